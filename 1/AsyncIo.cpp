@@ -0,0 +1,337 @@
+#include "AsyncIo.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <initializer_list>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define HAVE_IO_URING 1
+#endif
+
+namespace nonstd
+{
+#ifdef HAVE_IO_URING
+namespace
+{
+template<typename T>
+T* at(void* base, uint32_t offset)
+{
+  return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+// ring indices are shared with the kernel
+uint32_t load(const uint32_t* p)
+{
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+void store(uint32_t* p, uint32_t value)
+{
+  __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+// closes the ring when set up fails halfway too
+struct RingFd
+{
+  RingFd() = default;
+  RingFd(const RingFd&) = delete;
+  RingFd& operator=(const RingFd&) = delete;
+  ~RingFd()
+  {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+
+  int fd = -1;
+};
+
+struct Mapping
+{
+  Mapping() = default;
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+  ~Mapping()
+  {
+    if (data) {
+      munmap(data, size);
+    }
+  }
+
+  void* data = nullptr;
+  size_t size = 0;
+};
+}
+
+/**
+ * @brief io_uring set up with the raw system calls, liburing isn't needed
+ *
+ * @details
+ * Setting up throws unless the kernel supports reads and writes (5.6 on), the
+ * ring itself exists since 5.1.
+ */
+struct AsyncIo::Ring
+{
+  explicit Ring(unsigned entries)
+  {
+    auto params = io_uring_params();
+    memset(&params, 0, sizeof(params));
+    ring.fd = syscall(__NR_io_uring_setup, entries, &params);
+    fd = ring.fd;
+    if (fd < 0) {
+      throw "io_uring unavailable";
+    }
+    if (!supports({ IORING_OP_READ, IORING_OP_WRITE })) {
+      throw "io_uring unavailable";
+    }
+    auto sqSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    auto cqSize =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    auto single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+      sqSize = cqSize = std::max(sqSize, cqSize);
+    }
+    map(sqMap, sqSize, IORING_OFF_SQ_RING);
+    sq = sqMap.data;
+    if (single) {
+      cq = sq;
+    } else {
+      map(cqMap, cqSize, IORING_OFF_CQ_RING);
+      cq = cqMap.data;
+    }
+    map(sqesMap, params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES);
+    sqes = static_cast<io_uring_sqe*>(sqesMap.data);
+
+    sqHead = at<uint32_t>(sq, params.sq_off.head);
+    sqTail = at<uint32_t>(sq, params.sq_off.tail);
+    sqMask = *at<uint32_t>(sq, params.sq_off.ring_mask);
+    sqArray = at<uint32_t>(sq, params.sq_off.array);
+    cqHead = at<uint32_t>(cq, params.cq_off.head);
+    cqTail = at<uint32_t>(cq, params.cq_off.tail);
+    cqMask = *at<uint32_t>(cq, params.cq_off.ring_mask);
+    cqes = at<io_uring_cqe>(cq, params.cq_off.cqes);
+  }
+
+  Ring(const Ring&) = delete;
+  Ring& operator=(const Ring&) = delete;
+
+  // kernels before 5.6 have no probe and no IORING_OP_READ/WRITE either
+  bool supports(std::initializer_list<uint8_t> ops)
+  {
+    const unsigned count = 256;
+    auto buffer = std::vector<char>(sizeof(io_uring_probe) +
+                                    count * sizeof(io_uring_probe_op));
+    auto* probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe,
+                count) < 0) {
+      return false;
+    }
+    return std::all_of(ops.begin(), ops.end(), [probe](uint8_t op) {
+      return op <= probe->last_op &&
+             (probe->ops[op].flags & IO_URING_OP_SUPPORTED) != 0;
+    });
+  }
+
+  void map(Mapping& mapping, size_t size, off_t offset)
+  {
+    auto p = mmap(nullptr,
+                  size,
+                  PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE,
+                  fd,
+                  offset);
+    if (p == MAP_FAILED) {
+      throw "io_uring unavailable";
+    }
+    mapping.data = p;
+    mapping.size = size;
+  }
+
+  void submit(uint8_t op,
+              int file,
+              const char* data,
+              size_t size,
+              uint64_t offset,
+              uint64_t tag)
+  {
+    auto tail = *sqTail;
+    auto index = tail & sqMask;
+    auto& sqe = sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = op;
+    sqe.fd = file;
+    sqe.addr = reinterpret_cast<uint64_t>(data);
+    sqe.len = static_cast<uint32_t>(size);
+    sqe.off = offset;
+    sqe.user_data = tag;
+    sqArray[index] = index;
+    store(sqTail, tail + 1);
+    while (enter(1, 0, 0) < 0) {
+      if (load(sqHead) != tail) {
+        // taken by the kernel anyway, it completes like any other
+        return;
+      }
+      if (errno != EINTR) {
+        // not taken, so the next submit reuses the entry
+        store(sqTail, tail);
+        throw "io_uring submit failed";
+      }
+    }
+  }
+
+  IoCompletion wait()
+  {
+    auto head = *cqHead;
+    while (head == load(cqTail)) {
+      if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+        throw "io_uring wait failed";
+      }
+    }
+    const auto& cqe = cqes[head & cqMask];
+    auto done = IoCompletion{ cqe.user_data, cqe.res };
+    store(cqHead, head + 1);
+    return done;
+  }
+
+  long enter(unsigned submit, unsigned complete, unsigned flags)
+  {
+    return syscall(
+      __NR_io_uring_enter, fd, submit, complete, flags, nullptr, 0);
+  }
+
+  // unmapped before the ring is closed
+  RingFd ring;
+  Mapping sqMap;
+  Mapping cqMap;
+  Mapping sqesMap;
+  int fd = -1;
+  void* sq = nullptr;
+  void* cq = nullptr;
+  io_uring_sqe* sqes = nullptr;
+  uint32_t* sqHead = nullptr;
+  uint32_t* sqTail = nullptr;
+  uint32_t sqMask = 0;
+  uint32_t* sqArray = nullptr;
+  uint32_t* cqHead = nullptr;
+  uint32_t* cqTail = nullptr;
+  uint32_t cqMask = 0;
+  io_uring_cqe* cqes = nullptr;
+};
+#else
+struct AsyncIo::Ring
+{};
+#endif
+
+AsyncIo::AsyncIo(IoBackend backend, unsigned depth) : _depth(depth)
+{
+  if (depth == 0) {
+    throw "invalid depth";
+  }
+  if (backend == IoBackend::Threads ||
+      (backend == IoBackend::Auto && !uringAvailable())) {
+    return;
+  }
+#ifdef HAVE_IO_URING
+  _ring = std::make_unique<Ring>(depth);
+#else
+  throw "io_uring unavailable";
+#endif
+}
+
+AsyncIo::~AsyncIo()
+{
+  // the kernel may still write into buffers of pending requests
+  while (_ring && _pending > 0) {
+    try {
+      wait();
+    } catch (...) {
+      // the ring is broken, nothing more will complete
+      break;
+    }
+  }
+}
+
+bool AsyncIo::uringAvailable()
+{
+#ifdef HAVE_IO_URING
+  static const bool available = [] {
+    try {
+      Ring(1);
+      return true;
+    } catch (const char*) {
+      return false;
+    }
+  }();
+  return available;
+#else
+  return false;
+#endif
+}
+
+void AsyncIo::read(int fd,
+                   char* data,
+                   size_t size,
+                   uint64_t offset,
+                   uint64_t tag)
+{
+  submit(false, fd, data, size, offset, tag);
+}
+
+void AsyncIo::write(int fd,
+                    const char* data,
+                    size_t size,
+                    uint64_t offset,
+                    uint64_t tag)
+{
+  submit(true, fd, data, size, offset, tag);
+}
+
+void AsyncIo::submit(bool write,
+                     int fd,
+                     const char* data,
+                     size_t size,
+                     uint64_t offset,
+                     uint64_t tag)
+{
+  if (_pending == _depth) {
+    throw "too many pending requests";
+  }
+  // counted once submitted and until reaped, the destructor drains them all
+#ifdef HAVE_IO_URING
+  if (_ring) {
+    _ring->submit(
+      write ? IORING_OP_WRITE : IORING_OP_READ, fd, data, size, offset, tag);
+    ++_pending;
+    return;
+  }
+#endif
+  auto done = write ? pwrite(fd, data, size, offset)
+                    : pread(fd, const_cast<char*>(data), size, offset);
+  _done.push_back(IoCompletion{ tag, done < 0 ? -errno : done });
+  ++_pending;
+}
+
+IoCompletion AsyncIo::wait()
+{
+  if (_pending == 0) {
+    throw "nothing pending";
+  }
+#ifdef HAVE_IO_URING
+  if (_ring) {
+    auto done = _ring->wait();
+    --_pending;
+    return done;
+  }
+#endif
+  auto done = _done.front();
+  _done.pop_front();
+  --_pending;
+  return done;
+}
+}
@@ -0,0 +1,90 @@
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+namespace nonstd
+{
+/**
+ * @brief How AsyncIo performs requests
+ *
+ * Auto: Uring when the kernel supports it, Threads otherwise
+ * Uring: submitted to an io_uring, several in flight at once
+ * Threads: pread()/pwrite() on the submitting thread, overlap comes only from
+ * running every pipeline stage on its own thread
+ */
+enum class IoBackend { Auto, Uring, Threads };
+
+struct IoCompletion
+{
+  uint64_t tag;
+  // bytes transferred or -errno
+  int64_t result;
+};
+
+/**
+ * @brief Reads and writes at explicit offsets, completed in any order
+ *
+ * @details
+ * At most depth() requests may be pending, wait() returns one completion
+ * identified by the tag it was submitted with. Not thread safe, every thread
+ * needs its own instance.
+ */
+class AsyncIo
+{
+public:
+  AsyncIo(IoBackend backend, unsigned depth);
+  AsyncIo(const AsyncIo&) = delete;
+  AsyncIo(AsyncIo&&) = delete;
+  AsyncIo& operator=(const AsyncIo&) = delete;
+  AsyncIo& operator=(AsyncIo&&) = delete;
+  ~AsyncIo();
+
+  /**
+   * @brief Check once whether io_uring can be set up
+   */
+  static bool uringAvailable();
+
+  bool usesUring() const
+  {
+    return _ring != nullptr;
+  }
+
+  unsigned depth() const
+  {
+    return _depth;
+  }
+
+  size_t pending() const
+  {
+    return _pending;
+  }
+
+  void read(int fd, char* data, size_t size, uint64_t offset, uint64_t tag);
+  void write(int fd,
+             const char* data,
+             size_t size,
+             uint64_t offset,
+             uint64_t tag);
+  IoCompletion wait();
+
+private:
+  struct Ring;
+
+  void submit(bool write,
+              int fd,
+              const char* data,
+              size_t size,
+              uint64_t offset,
+              uint64_t tag);
+
+  unsigned _depth;
+  size_t _pending = 0;
+  std::unique_ptr<Ring> _ring;
+  std::deque<IoCompletion> _done;
+};
+}
+
+#endif
@@ -0,0 +1,469 @@
+#include "Batch.h"
+#include "Incremental.h"
+#include "Index.h"
+#include "Merge.h"
+#include "PatternSet.h"
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>
+#include <iomanip>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace fs = std::experimental::filesystem;
+
+namespace nonstd
+{
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+double since(Clock::time_point start)
+{
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::string message(std::exception_ptr error)
+{
+  try {
+    std::rethrow_exception(error);
+  } catch (const char* e) {
+    return e;
+  } catch (const std::exception& e) {
+    return e.what();
+  } catch (...) {
+    return "unknown error";
+  }
+}
+
+struct Fd
+{
+  explicit Fd(const std::string& path) :
+    fd(open(path.c_str(), O_RDONLY | O_CLOEXEC))
+  {
+    if (fd < 0) {
+      throw "invalid file";
+    }
+  }
+  Fd(const Fd&) = delete;
+  Fd& operator=(const Fd&) = delete;
+  ~Fd()
+  {
+    close(fd);
+  }
+
+  int fd;
+};
+
+/**
+ * @brief Offsets cutting a file into parts of about 'splitSize' bytes
+ *
+ * @details
+ * Every cut is moved forward to just after a newline, so parts hold whole
+ * lines. First offset is 0, the last one the file size.
+ */
+std::vector<uint64_t> cuts(int fd, uint64_t size, uint64_t splitSize)
+{
+  const uint64_t window = 64 * 1024;
+  auto result = std::vector<uint64_t>{ 0 };
+  auto buffer = std::string(window, '\0');
+  for (auto cut = splitSize; cut < size; cut += splitSize) {
+    cut = std::max(cut, result.back());
+    auto found = false;
+    while (!found && cut < size) {
+      auto got = pread(fd, &buffer[0], window, cut);
+      if (got <= 0) {
+        throw "read failed";
+      }
+      auto* nl = static_cast<const char*>(memchr(buffer.data(), '\n', got));
+      if (nl) {
+        cut += nl - buffer.data() + 1;
+        found = true;
+      } else {
+        cut += got;
+      }
+    }
+    if (cut < size && cut > result.back()) {
+      result.push_back(cut);
+    }
+  }
+  result.push_back(size);
+  return result;
+}
+
+struct SplitFile
+{
+  std::string path;
+  std::string output;
+  // name reserved next to the output, parts are named after it
+  std::string base;
+  std::vector<uint64_t> cuts;
+  std::atomic<size_t> remaining{ 0 };
+  std::atomic<bool> failed{ false };
+  Clock::time_point start;
+  std::once_flag started;
+  std::mutex mutex;
+  // workers the parts ran on
+  std::set<std::thread::id> threads;
+};
+
+// a name no other run uses, so parts of concurrent runs don't collide
+std::string reserve(const std::string& output)
+{
+  auto name = output + "_tmpXXXXXX";
+  auto fd = mkostemp(&name[0], O_CLOEXEC);
+  if (fd < 0) {
+    throw "can't open output file";
+  }
+  close(fd);
+  return name;
+}
+
+std::string partPath(const SplitFile& file, size_t part)
+{
+  return file.base + "_part" + std::to_string(part);
+}
+
+// removes the parts and the reserved name however the join ends
+struct PartFiles
+{
+  explicit PartFiles(const SplitFile& file) : base(file.base)
+  {
+    for (size_t i = 0; i + 1 < file.cuts.size(); ++i) {
+      names.push_back(partPath(file, i));
+    }
+  }
+  PartFiles(const PartFiles&) = delete;
+  PartFiles& operator=(const PartFiles&) = delete;
+  ~PartFiles()
+  {
+    auto error = std::error_code();
+    for (const auto& n : names) {
+      fs::remove(n, error);
+    }
+    fs::remove(base, error);
+  }
+
+  std::string base;
+  std::vector<std::string> names;
+};
+
+void processPart(SplitFile& file,
+                 size_t part,
+                 const PatternSet& patterns,
+                 const BatchOptions& options)
+{
+  auto lines = readLines(file.path, file.cuts[part], file.cuts[part + 1]);
+  if (!patterns.empty()) {
+    for (auto& l : lines) {
+      remove(l, patterns);
+    }
+  }
+  if (options.unique) {
+    unique(lines);
+  }
+  if (options.sort) {
+    sort(lines);
+  }
+  auto out = Writer(partPath(file, part));
+  for (const auto& l : lines) {
+    out.line(std::string_view(l.data(), l.size()));
+  }
+  out.close();
+}
+
+void join(const std::vector<std::string>& parts,
+          Writer& out,
+          const BatchOptions& options)
+{
+  if (options.sort) {
+    // earlier parts win ties, so the result equals sorting the whole file
+    mergeRuns(parts, out, options.unique);
+  } else {
+    std::string tmp;
+    for (const auto& p : parts) {
+      auto in = std::ifstream(p);
+      while (std::getline(in, tmp)) {
+        out.line(tmp);
+      }
+    }
+  }
+  out.close();
+}
+
+/**
+ * @brief Run by the last part to finish, replaces the output like Text does
+ *
+ * @details
+ * The joined output and its index are complete before they replace the old
+ * ones, a failing join or index leaves those as they were.
+ */
+void joinParts(const SplitFile& file, const BatchOptions& options)
+{
+  auto parts = PartFiles(file);
+  if (file.failed) {
+    return;
+  }
+  if (!AtomicFile::replaceable(file.output)) {
+    auto out = Writer(file.output,
+                      Writer::defaultBufferSize,
+                      false,
+                      false,
+                      options.compression);
+    join(parts.names, out, options);
+    if (options.index) {
+      buildIndex(file.output);
+    }
+    return;
+  }
+  auto target = AtomicFile(file.output);
+  {
+    auto out = Writer(target.temporary(),
+                      Writer::defaultBufferSize,
+                      false,
+                      false,
+                      options.compression);
+    join(parts.names, out, options);
+  }
+  if (!options.index) {
+    target.commit(false);
+    return;
+  }
+  // the index doesn't hold the name of its file, it is moved along
+  auto index = indexPath(target.temporary());
+  try {
+    buildIndex(target.temporary());
+    target.commit(false);
+    if (rename(index.c_str(), indexPath(file.output).c_str()) != 0) {
+      throw "write failed";
+    }
+  } catch (...) {
+    auto error = std::error_code();
+    fs::remove(index, error);
+    throw;
+  }
+}
+}
+
+std::vector<std::string> listFiles(const std::string& directory,
+                                   const std::string& suffix)
+{
+  if (!fs::is_directory(directory)) {
+    throw "invalid directory";
+  }
+  auto result = std::vector<std::string>();
+  for (const auto& entry : fs::recursive_directory_iterator(directory)) {
+    auto name = entry.path().filename().string();
+    if (fs::is_regular_file(entry.status()) &&
+        name.find(suffix) == std::string::npos) {
+      result.push_back(entry.path().string());
+    }
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+std::vector<std::string> readFileList(const std::string& path)
+{
+  auto in = std::ifstream(path);
+  if (!in.good()) {
+    throw "invalid file list";
+  }
+  auto result = std::vector<std::string>();
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty()) {
+      result.push_back(line);
+    }
+  }
+  return result;
+}
+
+BatchReport processFiles(const std::vector<std::string>& paths,
+                         const BatchOptions& options)
+{
+  if (options.incremental && options.unique) {
+    throw "unique can't run incrementally";
+  }
+  auto start = Clock::now();
+  auto report = BatchReport();
+  report.files.resize(paths.size());
+  for (size_t i = 0; i < paths.size(); ++i) {
+    auto& r = report.files[i];
+    r.path = paths[i];
+    auto error = std::error_code();
+    r.bytes = fs::file_size(paths[i], error);
+    if (error || !fs::is_regular_file(paths[i])) {
+      r.bytes = 0;
+      r.error = "invalid file";
+    }
+  }
+
+  auto order = std::vector<size_t>(paths.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return report.files[a].bytes > report.files[b].bytes;
+  });
+
+  auto patterns = PatternSet(options.patterns, options.ignoreCase);
+  auto splitFiles = std::vector<std::unique_ptr<SplitFile>>();
+  auto splittable = options.sort || !options.unique;
+  auto pool = ThreadPool(options.threads);
+  for (auto i : order) {
+    auto& r = report.files[i];
+    if (!r.error.empty()) {
+      continue;
+    }
+    auto output = r.path + options.suffix;
+    if (options.incremental) {
+      pool.submit([&r, &options] {
+        auto fileStart = Clock::now();
+        try {
+          auto o = IncrementalOptions{ options.patterns,
+                                       options.sort,
+                                       options.suffix,
+                                       options.ignoreCase };
+          auto done = processAppended(r.path, o);
+          r.bytes = done.end - done.begin;
+          if (options.index) {
+            buildIndex(r.path + options.suffix);
+          }
+        } catch (...) {
+          r.error = message(std::current_exception());
+        }
+        r.seconds = since(fileStart);
+      });
+      continue;
+    }
+    // parts are byte ranges, a compressed file is processed whole
+    if (!splittable || r.bytes <= options.splitSize ||
+        detectCompression(r.path) != Compression::None) {
+      pool.submit([&r, output, &options] {
+        auto fileStart = Clock::now();
+        try {
+          auto text = Text(r.path, options.storage);
+          text.setIndexed(options.index);
+          text.setOutputCompression(options.compression);
+          text.remove(options.patterns, options.ignoreCase);
+          if (options.unique) {
+            text.unique();
+          }
+          if (options.sort) {
+            text.sort();
+          }
+          text.toFile(output);
+          r.stats = toJson(text.stats());
+        } catch (...) {
+          r.error = message(std::current_exception());
+        }
+        r.seconds = since(fileStart);
+      });
+      continue;
+    }
+
+    splitFiles.push_back(std::make_unique<SplitFile>());
+    auto& file = *splitFiles.back();
+    file.path = r.path;
+    file.output = output;
+    try {
+      auto in = Fd(r.path);
+      file.cuts = cuts(in.fd, r.bytes, options.splitSize);
+      file.base = reserve(output);
+    } catch (...) {
+      r.error = message(std::current_exception());
+      continue;
+    }
+    r.parts = file.cuts.size() - 1;
+    file.remaining = r.parts;
+    // submitted from a worker, parts go to its deque and idle ones steal them
+    pool.submit([&pool, &r, &file, &patterns, &options] {
+      for (size_t part = 0; part < r.parts; ++part) {
+        pool.submit([&r, &file, part, &patterns, &options] {
+          std::call_once(file.started,
+                         [&file] { file.start = Clock::now(); });
+          {
+            auto lock = std::lock_guard<std::mutex>(file.mutex);
+            file.threads.insert(std::this_thread::get_id());
+          }
+          try {
+            processPart(file, part, patterns, options);
+          } catch (...) {
+            // other parts only read their own range, r.error is set once
+            if (!file.failed.exchange(true)) {
+              r.error = message(std::current_exception());
+            }
+          }
+          if (--file.remaining == 0) {
+            try {
+              joinParts(file, options);
+            } catch (...) {
+              r.error = message(std::current_exception());
+            }
+            r.threads = file.threads.size();
+            r.seconds = since(file.start);
+          }
+        });
+      }
+    });
+  }
+  pool.wait();
+
+  for (const auto& r : report.files) {
+    if (r.error.empty()) {
+      report.bytes += r.bytes;
+    } else {
+      ++report.failed;
+    }
+  }
+  report.seconds = since(start);
+  return report;
+}
+
+void printReport(std::ostream& os, const BatchReport& report)
+{
+  auto rate = [](uint64_t bytes, double seconds) {
+    return seconds > 0 ? bytes / seconds / (1024 * 1024) : 0.0;
+  };
+  os << std::fixed << std::setprecision(3);
+  for (const auto& r : report.files) {
+    os << r.path << '\t';
+    if (!r.error.empty()) {
+      os << "error: " << r.error << '\n';
+      continue;
+    }
+    os << r.bytes << " B\t" << r.parts
+       << (r.parts == 1 ? " part\t" : " parts\t") << r.seconds << " s\t"
+       << rate(r.bytes, r.seconds) << " MiB/s\n";
+  }
+  os << "total\t" << report.files.size() - report.failed << " files\t"
+     << report.bytes << " B\t" << report.seconds << " s\t"
+     << rate(report.bytes, report.seconds) << " MiB/s";
+  if (report.failed > 0) {
+    os << '\t' << report.failed << " failed";
+  }
+  os << '\n';
+}
+
+void printStats(std::ostream& os, const BatchReport& report)
+{
+  os << '[';
+  for (size_t i = 0; i < report.files.size(); ++i) {
+    const auto& r = report.files[i];
+    os << (i > 0 ? "," : "") << "{\"path\":\"";
+    for (auto c : r.path) {
+      if (c == '"' || c == '\\') {
+        os << '\\';
+      }
+      os << c;
+    }
+    os << "\",\"stats\":" << (r.stats.empty() ? "null" : r.stats) << '}';
+  }
+  os << "]\n";
+}
+}
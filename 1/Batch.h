@@ -0,0 +1,94 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Text.h"
+
+namespace nonstd
+{
+struct BatchOptions
+{
+  static constexpr uint64_t defaultSplitSize = 64 * 1024 * 1024;
+
+  std::vector<std::string> patterns;
+  // remove every ASCII case variant of the patterns
+  bool ignoreCase = false;
+  bool sort = false;
+  bool unique = false;
+  // 0 means one per hardware thread
+  size_t threads = 0;
+  // files larger than this are processed in parts of about this size
+  uint64_t splitSize = defaultSplitSize;
+  // output of every file is written next to it with this suffix
+  std::string suffix = "_processed";
+  Storage storage = Storage::Mapped;
+  // process only what was appended since the last incremental run
+  bool incremental = false;
+  // write a SortedIndex next to every sorted output
+  bool index = false;
+  // format outputs are written in, compressed input is always detected
+  Compression compression = Compression::None;
+};
+
+struct FileReport
+{
+  std::string path;
+  uint64_t bytes = 0;
+  size_t parts = 1;
+  // workers the parts ran on
+  size_t threads = 1;
+  double seconds = 0;
+  // empty if the file was processed
+  std::string error;
+  // Text::stats() as JSON, empty for split and incremental files
+  std::string stats;
+};
+
+struct BatchReport
+{
+  std::vector<FileReport> files;
+  uint64_t bytes = 0;
+  double seconds = 0;
+  size_t failed = 0;
+};
+
+/**
+ * @brief Regular files below 'directory', outputs of earlier runs excluded
+ */
+std::vector<std::string> listFiles(const std::string& directory,
+                                   const std::string& suffix = "_processed");
+
+/**
+ * @brief Paths listed one per line in 'path'
+ */
+std::vector<std::string> readFileList(const std::string& path);
+
+/**
+ * @brief Process every file like Text: remove, unique, sort, toFile
+ *
+ * @details
+ * Files are jobs of a work stealing ThreadPool, largest first. A file larger
+ * than splitSize is cut at newlines into parts processed as separate jobs,
+ * submitted by one job of the file so idle workers steal them. The last part
+ * to finish merges the sorted parts (or concatenates them without sort) into
+ * the output, replaced atomically like Text::toFile() does. unique() without
+ * sort() needs the whole file and such files are never split. Incremental
+ * files go through processAppended() unsplit, their reported bytes are the
+ * ones processed. A failing file is reported and doesn't stop the others.
+ */
+BatchReport processFiles(const std::vector<std::string>& paths,
+                         const BatchOptions& options);
+
+void printReport(std::ostream& os, const BatchReport& report);
+
+/**
+ * @brief Write stats of all files as a JSON array of {"path", "stats"}
+ */
+void printStats(std::ostream& os, const BatchReport& report);
+}
+
+#endif
@@ -0,0 +1,185 @@
+#include "CaseFold.h"
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace nonstd
+{
+namespace
+{
+#if defined(__AVX2__)
+inline __m256i fold(__m256i v)
+{
+  auto upper =
+    _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('A' - 1)),
+                     _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), v));
+  return _mm256_add_epi8(v, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+#endif
+
+#if defined(__SSE2__)
+inline __m128i fold(__m128i v)
+{
+  auto upper = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('A' - 1)),
+                             _mm_cmplt_epi8(v, _mm_set1_epi8('Z' + 1)));
+  return _mm_add_epi8(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+#endif
+
+// folds 8 ASCII bytes at once
+inline uint64_t fold(uint64_t x)
+{
+  const uint64_t ones = 0x0101010101010101;
+  auto low = x & (ones * 0x7f);
+  auto fromA = low + ones * (0x80 - 'A');
+  auto afterZ = low + ones * (0x80 - 'Z' - 1);
+  auto upper = fromA & ~afterZ & ~x & (ones * 0x80);
+  return x | (upper >> 2);
+}
+
+inline uint64_t mix(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccd;
+  h ^= h >> 33;
+  return h;
+}
+
+inline int difference(const char* a, const char* b, size_t i)
+{
+  return nonstd::fold(a[i]) - nonstd::fold(b[i]);
+}
+}
+
+int compare(const char* a, const char* b, size_t n)
+{
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 32 <= n; i += 32) {
+    auto x = fold(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)));
+    auto y = fold(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+    auto equal = static_cast<uint32_t>(
+      _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+    if (equal != UINT32_MAX) {
+      return difference(a, b, i + __builtin_ctz(~equal));
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  for (; i + 16 <= n; i += 16) {
+    auto x = fold(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+    auto y = fold(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+    auto equal = _mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+    if (equal != 0xffff) {
+      return difference(a, b, i + __builtin_ctz(~equal));
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    if (a[i] != b[i]) {
+      auto d = difference(a, b, i);
+      if (d != 0) {
+        return d;
+      }
+    }
+  }
+  return 0;
+}
+
+int compare(const char* a, size_t an, const char* b, size_t bn)
+{
+  auto c = compare(a, b, std::min(an, bn));
+  if (c != 0) {
+    return c;
+  }
+  return an < bn ? -1 : an > bn;
+}
+
+uint64_t prefixKey(const char* data, size_t size)
+{
+  uint64_t key = 0;
+  auto n = std::min<size_t>(size, 8);
+  for (size_t i = 0; i < n; ++i) {
+    key |= uint64_t(nonstd::fold(data[i])) << (56 - 8 * i);
+  }
+  return key;
+}
+
+uint64_t foldedHash(const char* data, size_t size, uint64_t seed)
+{
+  uint64_t h = 0x9e3779b97f4a7c15 ^ size ^ mix(seed * 0xc2b2ae3d27d4eb4f);
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, 8);
+    h = mix(h ^ fold(word)) * 0x9e3779b97f4a7c15;
+  }
+  uint64_t tail = 0;
+  for (size_t shift = 0; i < size; ++i, shift += 8) {
+    tail |= uint64_t(nonstd::fold(data[i])) << shift;
+  }
+  return mix(h ^ tail);
+}
+
+size_t findFolded(const char* data,
+                  size_t size,
+                  const char* pattern,
+                  size_t m)
+{
+  if (m == 0 || size < m) {
+    return SIZE_MAX;
+  }
+  auto first = nonstd::fold(pattern[0]);
+  auto last = nonstd::fold(pattern[m - 1]);
+  // first and last bytes are known to match
+  auto middle = m > 2 ? m - 2 : 0;
+  size_t i = 0;
+#if defined(__AVX2__)
+  auto first32 = _mm256_set1_epi8(first);
+  auto last32 = _mm256_set1_epi8(last);
+  for (; i + m - 1 + 32 <= size; i += 32) {
+    auto a =
+      fold(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)));
+    auto b = fold(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + m - 1)));
+    auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(
+      _mm256_cmpeq_epi8(a, first32), _mm256_cmpeq_epi8(b, last32))));
+    for (; mask != 0; mask &= mask - 1) {
+      auto at = i + __builtin_ctz(mask);
+      if (compare(data + at + 1, pattern + 1, middle) == 0) {
+        return at;
+      }
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  auto first16 = _mm_set1_epi8(first);
+  auto last16 = _mm_set1_epi8(last);
+  for (; i + m - 1 + 16 <= size; i += 16) {
+    auto a = fold(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+    auto b = fold(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + m - 1)));
+    uint32_t mask = _mm_movemask_epi8(
+      _mm_and_si128(_mm_cmpeq_epi8(a, first16), _mm_cmpeq_epi8(b, last16)));
+    for (; mask != 0; mask &= mask - 1) {
+      auto at = i + __builtin_ctz(mask);
+      if (compare(data + at + 1, pattern + 1, middle) == 0) {
+        return at;
+      }
+    }
+  }
+#endif
+  for (; i + m <= size; ++i) {
+    if (nonstd::fold(data[i]) == first &&
+        nonstd::fold(data[i + m - 1]) == last &&
+        compare(data + i + 1, pattern + 1, middle) == 0) {
+      return i;
+    }
+  }
+  return SIZE_MAX;
+}
+}
@@ -0,0 +1,70 @@
+#ifndef CASE_FOLD_H
+#define CASE_FOLD_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace nonstd
+{
+/**
+ * @brief ASCII lower case of a byte, other bytes are unchanged
+ */
+inline unsigned char fold(unsigned char c)
+{
+  return c + ((unsigned(c - 'A') < 26u) << 5);
+}
+
+/**
+ * @brief Case-insensitive comparison of exactly n bytes
+ *
+ * @details
+ * Bytes are ASCII case folded and compared as unsigned, NUL is an ordinary
+ * byte. Uses AVX2 or SSE2 when the build targets them.
+ *
+ * @return <0, 0 or >0 like memcmp
+ */
+int compare(const char* a, const char* b, size_t n);
+
+/**
+ * @brief Case-insensitive comparison of two byte ranges
+ *
+ * @details
+ * A range which is a prefix of the other one goes first.
+ */
+int compare(const char* a, size_t an, const char* b, size_t bn);
+
+/**
+ * @brief First 8 case folded bytes as a big-endian integer
+ *
+ * @details
+ * Missing bytes of shorter ranges are 0. If the keys of two ranges differ
+ * they are ordered like the ranges, equal keys need a full compare().
+ */
+uint64_t prefixKey(const char* data, size_t size);
+
+/**
+ * @brief Hash of case folded bytes, equal for lines compare() finds equal
+ *
+ * @details
+ * Every 'seed' gives another hash, lines colliding under one mostly don't
+ * under the others.
+ */
+uint64_t foldedHash(const char* data, size_t size, uint64_t seed = 0);
+
+/**
+ * @brief Case-insensitive search of 'pattern' in data
+ *
+ * @details
+ * Folds 32 (AVX2) or 16 (SSE2) bytes at once and compares them with the
+ * folded first and last byte of the pattern, only positions where both match
+ * are compared in full.
+ *
+ * @return position of the first occurrence or SIZE_MAX
+ */
+size_t findFolded(const char* data,
+                  size_t size,
+                  const char* pattern,
+                  size_t m);
+}
+
+#endif
@@ -0,0 +1,331 @@
+#include "Compression.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace nonstd
+{
+namespace
+{
+constexpr size_t inputSize = 256 * 1024;
+constexpr size_t outputSize = 256 * 1024;
+
+size_t readSome(int fd, char* data, size_t size)
+{
+  while (true) {
+    auto n = ::read(fd, data, size);
+    if (n >= 0) {
+      return n;
+    }
+    if (errno != EINTR) {
+      throw "can't read file";
+    }
+  }
+}
+
+void writeAll(int fd, const char* data, size_t size)
+{
+  while (size > 0) {
+    auto n = ::write(fd, data, size);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw "can't write output file";
+    }
+    data += n;
+    size -= n;
+  }
+}
+
+Bytef* bytes(const char* data)
+{
+  return reinterpret_cast<Bytef*>(const_cast<char*>(data));
+}
+}
+
+Compression detectCompression(const std::string& path)
+{
+  auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    // opening it for reading reports the error
+    return Compression::None;
+  }
+  unsigned char magic[4] = {};
+  auto n = pread(fd, magic, sizeof(magic), 0);
+  close(fd);
+  if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+    return Compression::Gzip;
+  }
+  if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f &&
+      magic[3] == 0xfd) {
+    return Compression::Zstd;
+  }
+  return Compression::None;
+}
+
+Decompressor::Decompressor(const std::string& path) : _blocks(4)
+{
+  auto compression = detectCompression(path);
+#ifndef HAVE_ZSTD
+  if (compression == Compression::Zstd) {
+    throw "zstd not supported";
+  }
+#endif
+  auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    throw "invalid file";
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  _thread = std::thread([this, fd, compression] {
+    try {
+      run(fd, compression);
+    } catch (...) {
+      _error = std::current_exception();
+    }
+    close(fd);
+    _blocks.close();
+  });
+}
+
+Decompressor::~Decompressor()
+{
+  _stop = true;
+  _blocks.close();
+  _thread.join();
+}
+
+size_t Decompressor::read(char* data, size_t size)
+{
+  while (_at == _block.size()) {
+    _at = 0;
+    if (!_blocks.pop(_block)) {
+      _block.clear();
+      if (_error) {
+        std::rethrow_exception(_error);
+      }
+      return 0;
+    }
+  }
+  auto n = std::min(size, _block.size() - _at);
+  memcpy(data, _block.data() + _at, n);
+  _at += n;
+  return n;
+}
+
+void Decompressor::run(int fd, Compression compression)
+{
+  auto input = std::unique_ptr<char[]>(new char[inputSize]);
+  if (compression == Compression::None) {
+    while (!_stop) {
+      auto block = std::string(blockSize, '\0');
+      block.resize(readSome(fd, &block[0], block.size()));
+      if (block.empty()) {
+        break;
+      }
+      _blocks.push(std::move(block));
+    }
+    return;
+  }
+
+#ifdef HAVE_ZSTD
+  if (compression == Compression::Zstd) {
+    auto stream = std::unique_ptr<ZSTD_DStream, size_t (*)(ZSTD_DStream*)>(
+      ZSTD_createDStream(), ZSTD_freeDStream);
+    ZSTD_initDStream(stream.get());
+    // 0 once a frame is complete
+    size_t hint = 0;
+    while (!_stop) {
+      auto n = readSome(fd, input.get(), inputSize);
+      if (n == 0) {
+        break;
+      }
+      auto in = ZSTD_inBuffer{ input.get(), n, 0 };
+      auto full = false;
+      while ((in.pos < in.size || full) && !_stop) {
+        auto block = std::string(blockSize, '\0');
+        auto out = ZSTD_outBuffer{ &block[0], block.size(), 0 };
+        hint = ZSTD_decompressStream(stream.get(), &out, &in);
+        if (ZSTD_isError(hint)) {
+          throw "corrupt compressed input";
+        }
+        full = out.pos == out.size;
+        block.resize(out.pos);
+        if (!block.empty()) {
+          _blocks.push(std::move(block));
+        }
+      }
+    }
+    if (hint != 0 && !_stop) {
+      throw "truncated compressed input";
+    }
+    return;
+  }
+#endif
+
+  auto z = z_stream();
+  memset(&z, 0, sizeof(z));
+  // 32 accepts gzip and zlib headers
+  if (inflateInit2(&z, 15 + 32) != Z_OK) {
+    throw "can't decompress";
+  }
+  auto end = std::unique_ptr<z_stream, int (*)(z_stream*)>(&z, inflateEnd);
+  auto ended = false;
+  while (!_stop) {
+    auto n = readSome(fd, input.get(), inputSize);
+    if (n == 0) {
+      break;
+    }
+    z.next_in = bytes(input.get());
+    z.avail_in = n;
+    auto full = false;
+    while ((z.avail_in > 0 || full) && !_stop) {
+      if (ended) {
+        // next member of a concatenated file
+        inflateReset(&z);
+        ended = false;
+      }
+      auto block = std::string(blockSize, '\0');
+      z.next_out = bytes(block.data());
+      z.avail_out = block.size();
+      auto rc = inflate(&z, Z_NO_FLUSH);
+      if (rc == Z_STREAM_END) {
+        ended = true;
+      } else if (rc != Z_OK && rc != Z_BUF_ERROR) {
+        throw "corrupt compressed input";
+      }
+      full = z.avail_out == 0;
+      block.resize(block.size() - z.avail_out);
+      if (!block.empty()) {
+        _blocks.push(std::move(block));
+      }
+      if (rc == Z_BUF_ERROR || (ended && z.avail_in == 0)) {
+        break;
+      }
+    }
+  }
+  if (!ended && !_stop) {
+    throw "truncated compressed input";
+  }
+}
+
+struct Compressor::State
+{
+  Compression compression;
+  z_stream z;
+#ifdef HAVE_ZSTD
+  ZSTD_CStream* zstd = nullptr;
+#endif
+};
+
+Compressor::Compressor(Compression compression, int fd) :
+  _state(new State{ compression, z_stream() }),
+  _fd(fd),
+  _out(new char[outputSize])
+{
+  if (compression == Compression::Gzip) {
+    memset(&_state->z, 0, sizeof(_state->z));
+    // 16 writes a gzip header and trailer
+    if (deflateInit2(&_state->z,
+                     Z_DEFAULT_COMPRESSION,
+                     Z_DEFLATED,
+                     15 + 16,
+                     8,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      throw "can't compress";
+    }
+  } else if (compression == Compression::Zstd) {
+#ifdef HAVE_ZSTD
+    _state->zstd = ZSTD_createCStream();
+    ZSTD_initCStream(_state->zstd, 3);
+#else
+    throw "zstd not supported";
+#endif
+  }
+}
+
+Compressor::~Compressor()
+{
+  if (_state->compression == Compression::Gzip) {
+    deflateEnd(&_state->z);
+  }
+#ifdef HAVE_ZSTD
+  ZSTD_freeCStream(_state->zstd);
+#endif
+}
+
+void Compressor::write(std::string_view data)
+{
+  if (_state->compression == Compression::None) {
+    writeAll(_fd, data.data(), data.size());
+    return;
+  }
+#ifdef HAVE_ZSTD
+  if (_state->compression == Compression::Zstd) {
+    auto in = ZSTD_inBuffer{ data.data(), data.size(), 0 };
+    while (in.pos < in.size) {
+      auto out = ZSTD_outBuffer{ _out.get(), outputSize, 0 };
+      if (ZSTD_isError(ZSTD_compressStream(_state->zstd, &out, &in))) {
+        throw "can't compress";
+      }
+      drain(out.pos);
+    }
+    return;
+  }
+#endif
+  auto& z = _state->z;
+  z.next_in = bytes(data.data());
+  z.avail_in = data.size();
+  do {
+    z.next_out = bytes(_out.get());
+    z.avail_out = outputSize;
+    deflate(&z, Z_NO_FLUSH);
+    drain(outputSize - z.avail_out);
+  } while (z.avail_out == 0);
+}
+
+void Compressor::finish()
+{
+  if (_state->compression == Compression::None) {
+    return;
+  }
+#ifdef HAVE_ZSTD
+  if (_state->compression == Compression::Zstd) {
+    size_t left = 0;
+    do {
+      auto out = ZSTD_outBuffer{ _out.get(), outputSize, 0 };
+      left = ZSTD_endStream(_state->zstd, &out);
+      if (ZSTD_isError(left)) {
+        throw "can't compress";
+      }
+      drain(out.pos);
+    } while (left != 0);
+    return;
+  }
+#endif
+  auto& z = _state->z;
+  auto rc = Z_OK;
+  do {
+    z.next_out = bytes(_out.get());
+    z.avail_out = outputSize;
+    rc = deflate(&z, Z_FINISH);
+    drain(outputSize - z.avail_out);
+  } while (rc == Z_OK);
+  if (rc != Z_STREAM_END) {
+    throw "can't compress";
+  }
+}
+
+void Compressor::drain(size_t produced)
+{
+  writeAll(_fd, _out.get(), produced);
+}
+}
@@ -0,0 +1,104 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "Queue.h"
+
+namespace nonstd
+{
+/**
+ * @brief Stream format of a file
+ *
+ * Gzip is always available, Zstd only when built with HAVE_ZSTD
+ */
+enum class Compression { None, Gzip, Zstd };
+
+/**
+ * @brief Format of 'path' judged by its magic bytes
+ */
+Compression detectCompression(const std::string& path);
+
+/**
+ * @brief Decompresses a file on its own thread
+ *
+ * @details
+ * The thread reads and inflates the file into blocks handed over through a
+ * bounded queue, so decompressing overlaps with whatever the caller does with
+ * the previous blocks. Concatenated gzip members are read as one stream.
+ */
+class Decompressor
+{
+public:
+  static constexpr size_t blockSize = 1024 * 1024;
+
+  /**
+   * @throw "invalid file" if 'path' can't be opened
+   * @throw "zstd not supported" for zstd input without HAVE_ZSTD
+   */
+  explicit Decompressor(const std::string& path);
+  Decompressor(const Decompressor&) = delete;
+  Decompressor(Decompressor&&) = delete;
+  Decompressor& operator=(const Decompressor&) = delete;
+  Decompressor& operator=(Decompressor&&) = delete;
+  ~Decompressor();
+
+  /**
+   * @brief Copy up to 'size' decompressed bytes to 'data'
+   *
+   * @return bytes copied, 0 at the end of the stream
+   * @throw what decompressing threw, e.g. "corrupt compressed input"
+   */
+  size_t read(char* data, size_t size);
+
+private:
+  void run(int fd, Compression compression);
+
+  BoundedQueue<std::string> _blocks;
+  std::string _block;
+  size_t _at = 0;
+  std::atomic<bool> _stop{ false };
+  std::exception_ptr _error;
+  std::thread _thread;
+};
+
+/**
+ * @brief Compresses a byte stream into a file descriptor
+ */
+class Compressor
+{
+public:
+  /**
+   * @throw "zstd not supported" for Zstd without HAVE_ZSTD
+   */
+  Compressor(Compression compression, int fd);
+  Compressor(const Compressor&) = delete;
+  Compressor(Compressor&&) = delete;
+  Compressor& operator=(const Compressor&) = delete;
+  Compressor& operator=(Compressor&&) = delete;
+  ~Compressor();
+
+  void write(std::string_view data);
+
+  /**
+   * @brief Write the end of the stream, nothing can be written after it
+   */
+  void finish();
+
+private:
+  struct State;
+
+  void drain(size_t produced);
+
+  std::unique_ptr<State> _state;
+  int _fd;
+  std::unique_ptr<char[]> _out;
+};
+}
+
+#endif
@@ -0,0 +1,276 @@
+#include "Incremental.h"
+#include "Merge.h"
+#include "PatternSet.h"
+#include "Text.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::experimental::filesystem;
+
+namespace nonstd
+{
+namespace
+{
+const char* const stateHeader = "ci_string state 3";
+const uint64_t window = 64 * 1024;
+
+struct State
+{
+  uint64_t offset = 0;
+  uint64_t checksum = 0;
+  uint64_t outputSize = 0;
+  bool sort = false;
+  bool ignoreCase = false;
+  std::vector<std::string> patterns;
+};
+
+struct Input
+{
+  explicit Input(const std::string& path) :
+    fd(open(path.c_str(), O_RDONLY | O_CLOEXEC))
+  {
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+      if (fd >= 0) {
+        close(fd);
+      }
+      throw "invalid file";
+    }
+    size = st.st_size;
+  }
+  Input(const Input&) = delete;
+  Input& operator=(const Input&) = delete;
+  ~Input()
+  {
+    close(fd);
+  }
+
+  std::string read(uint64_t begin, uint64_t end) const
+  {
+    auto data = std::string(end - begin, '\0');
+    uint64_t done = 0;
+    while (done < data.size()) {
+      auto got = pread(fd, &data[done], data.size() - done, begin + done);
+      if (got <= 0) {
+        throw "read failed";
+      }
+      done += got;
+    }
+    return data;
+  }
+
+  int fd;
+  uint64_t size;
+};
+
+const uint64_t emptyChecksum = 0xcbf29ce484222325;
+
+// FNV-1a
+uint64_t hash(uint64_t h, const std::string& data)
+{
+  for (auto c : data) {
+    h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+  }
+  return h;
+}
+
+/**
+ * @brief Continue checksum 'h' of [0, begin) over [begin, end)
+ *
+ * @details
+ * Every byte counts, so edits in place are caught too. It is one sequential
+ * read, lines aren't split, edited or sorted again.
+ */
+uint64_t prefixChecksum(const Input& in,
+                        uint64_t h,
+                        uint64_t begin,
+                        uint64_t end)
+{
+  const uint64_t block = 16 * window;
+  for (auto b = begin; b < end; b += block) {
+    h = hash(h, in.read(b, std::min(end, b + block)));
+  }
+  return h;
+}
+
+// mkostemp name next to the output, removed with the object
+struct RunFile
+{
+  explicit RunFile(const std::string& output) : name(output + "_tmpXXXXXX")
+  {
+    auto fd = mkostemp(&name[0], O_CLOEXEC);
+    if (fd < 0) {
+      throw "can't open output file";
+    }
+    close(fd);
+  }
+  RunFile(const RunFile&) = delete;
+  RunFile& operator=(const RunFile&) = delete;
+  ~RunFile()
+  {
+    auto error = std::error_code();
+    fs::remove(name, error);
+  }
+
+  std::string name;
+};
+
+// offset just after the last newline, 0 if there is none
+uint64_t completeLines(const Input& in)
+{
+  for (auto end = in.size; end > 0;) {
+    auto begin = end - std::min(window, end);
+    auto data = in.read(begin, end);
+    auto* nl =
+      static_cast<const char*>(memrchr(data.data(), '\n', data.size()));
+    if (nl) {
+      return begin + (nl - data.data()) + 1;
+    }
+    end = begin;
+  }
+  return 0;
+}
+
+bool readState(const std::string& path, State& state)
+{
+  auto in = std::ifstream(path);
+  std::string line;
+  if (!std::getline(in, line) || line != stateHeader) {
+    return false;
+  }
+  std::string key;
+  size_t count = 0;
+  in >> key >> state.offset >> key >> state.checksum >> key >>
+    state.outputSize >> key >> state.sort >> key >> state.ignoreCase >> key >>
+    count;
+  for (size_t i = 0; i < count && in; ++i) {
+    size_t size = 0;
+    in >> size;
+    in.get();
+    auto p = std::string(size, '\0');
+    in.read(&p[0], size);
+    state.patterns.push_back(p);
+  }
+  return bool(in);
+}
+
+void writeState(const std::string& path, const State& state)
+{
+  // written aside and renamed, a crash leaves the old state or the new one
+  auto tmp = path + "_tmp";
+  {
+    auto out = std::ofstream(tmp);
+    out << stateHeader << "\noffset " << state.offset << "\nchecksum "
+        << state.checksum << "\noutput " << state.outputSize << "\nsort "
+        << state.sort << "\nignore_case " << state.ignoreCase << "\npatterns "
+        << state.patterns.size() << '\n';
+    for (const auto& p : state.patterns) {
+      out << p.size() << ' ' << p << '\n';
+    }
+    if (!out) {
+      throw "can't write state file";
+    }
+  }
+  fs::rename(tmp, path);
+}
+
+void writeLines(Writer& out, const Lines& lines)
+{
+  for (const auto& l : lines) {
+    out.line(std::string_view(l.data(), l.size()));
+  }
+  out.close();
+}
+}
+
+std::string statePath(const std::string& path, const std::string& suffix)
+{
+  return path + suffix + ".state";
+}
+
+IncrementalResult processAppended(const std::string& path,
+                                  const IncrementalOptions& options)
+{
+  if (detectCompression(path) != Compression::None) {
+    // appended bytes of a compressed stream aren't lines
+    throw "compressed input can't be processed incrementally";
+  }
+  auto in = Input(path);
+  auto output = path + options.suffix;
+  auto stateFile = statePath(path, options.suffix);
+  auto end = completeLines(in);
+
+  auto state = State();
+  auto error = std::error_code();
+  auto result = IncrementalResult();
+  result.appended =
+    readState(stateFile, state) && state.sort == options.sort &&
+    state.ignoreCase == options.ignoreCase &&
+    state.patterns == options.patterns && state.offset <= end &&
+    fs::file_size(output, error) == state.outputSize && !error &&
+    prefixChecksum(in, emptyChecksum, 0, state.offset) == state.checksum;
+  result.begin = result.appended ? state.offset : 0;
+  auto checksum = prefixChecksum(in,
+                                 result.appended ? state.checksum
+                                                 : emptyChecksum,
+                                 result.begin,
+                                 end);
+  result.end = end;
+
+  auto lines = readLines(path, result.begin, result.end);
+  auto patterns = PatternSet(options.patterns, options.ignoreCase);
+  if (!patterns.empty()) {
+    for (auto& l : lines) {
+      remove(l, patterns);
+    }
+  }
+  if (options.sort) {
+    sort(lines);
+  }
+
+  if (!result.appended) {
+    if (AtomicFile::replaceable(output)) {
+      auto file = AtomicFile(output);
+      {
+        auto out = Writer(file.temporary());
+        writeLines(out, lines);
+      }
+      file.commit(false);
+    } else {
+      auto out = Writer(output);
+      writeLines(out, lines);
+    }
+  } else if (!options.sort) {
+    auto out = Writer(output, Writer::defaultBufferSize, false, true);
+    writeLines(out, lines);
+  } else if (!lines.empty()) {
+    // output of an earlier sorted run is a regular file
+    auto run = RunFile(output);
+    {
+      auto out = Writer(run.name);
+      writeLines(out, lines);
+    }
+    auto file = AtomicFile(output);
+    {
+      // old output first on ties, as if the whole input was sorted
+      auto out = Writer(file.temporary());
+      mergeRuns({ output, run.name }, out);
+      out.close();
+    }
+    file.commit(false);
+  }
+
+  state.offset = end;
+  state.checksum = checksum;
+  state.outputSize = fs::file_size(output);
+  state.sort = options.sort;
+  state.ignoreCase = options.ignoreCase;
+  state.patterns = options.patterns;
+  writeState(stateFile, state);
+  return result;
+}
+}
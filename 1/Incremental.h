@@ -0,0 +1,49 @@
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nonstd
+{
+struct IncrementalOptions
+{
+  std::vector<std::string> patterns;
+  bool sort = false;
+  std::string suffix = "_processed";
+  bool ignoreCase = false;
+};
+
+struct IncrementalResult
+{
+  // false if the whole file was processed again
+  bool appended = false;
+  // bytes of input processed by this run
+  uint64_t begin = 0;
+  uint64_t end = 0;
+};
+
+/**
+ * @brief Path of the state kept next to the output of 'path'
+ */
+std::string statePath(const std::string& path,
+                      const std::string& suffix = "_processed");
+
+/**
+ * @brief Process only what was appended to 'path' since the previous run
+ *
+ * @details
+ * The state file records how far the input was processed, a checksum of
+ * every byte before that offset, the options and the output size. When all of
+ * them still match, lines after the offset are processed and appended to the
+ * output, or with sort merged into the sorted output through a temporary
+ * file. Otherwise the whole input is processed again and replaces the output
+ * atomically. A last line without newline may still be growing and waits for
+ * the next run.
+ */
+IncrementalResult processAppended(const std::string& path,
+                                  const IncrementalOptions& options);
+}
+
+#endif
@@ -0,0 +1,227 @@
+#include "Index.h"
+#include "CaseFold.h"
+#include "Newlines.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace nonstd
+{
+namespace
+{
+const char magic[8] = { 'C', 'I', 'I', 'D', 'X', '1', '\0', '\0' };
+
+struct Header
+{
+  char magic[8];
+  uint64_t lines;
+  uint64_t fileSize;
+  uint64_t step;
+  uint64_t keys;
+};
+
+// whole file mapped read-only, nullptr if it is empty
+const char* mapFile(const std::string& path, size_t& size)
+{
+  auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    throw "invalid file";
+  }
+  size = st.st_size;
+  void* map = nullptr;
+  if (size != 0) {
+    map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (map == MAP_FAILED) {
+    throw "can't map file";
+  }
+  return static_cast<const char*>(map);
+}
+
+void unmap(const void* data, size_t size)
+{
+  if (data) {
+    munmap(const_cast<void*>(data), size);
+  }
+}
+
+uint64_t keyCount(uint64_t lines, uint64_t step)
+{
+  return step == 0 ? 0 : (lines + step - 1) / step;
+}
+}
+
+std::string indexPath(const std::string& path)
+{
+  return path + ".idx";
+}
+
+void buildIndex(const std::string& path, size_t sparseStep)
+{
+  size_t size = 0;
+  auto data = mapFile(path, size);
+  madvise(const_cast<char*>(data), size, MADV_SEQUENTIAL);
+  auto offsets = std::vector<uint64_t>();
+  auto keys = std::vector<uint64_t>();
+  auto sorted = true;
+  size_t previous = 0;
+  size_t previousEnd = 0;
+  forEachLine(data, size, [&](size_t begin, size_t end) {
+    if (!offsets.empty() && compare(data + previous,
+                                    previousEnd - previous,
+                                    data + begin,
+                                    end - begin) > 0) {
+      sorted = false;
+    }
+    if (sparseStep != 0 && offsets.size() % sparseStep == 0) {
+      keys.push_back(prefixKey(data + begin, end - begin));
+    }
+    offsets.push_back(begin);
+    previous = begin;
+    previousEnd = end;
+  });
+  unmap(data, size);
+  if (!sorted) {
+    throw "output not sorted";
+  }
+
+  auto header = Header{ {}, offsets.size(), size, sparseStep, keys.size() };
+  memcpy(header.magic, magic, sizeof(magic));
+  auto tmp = indexPath(path) + "_tmp";
+  {
+    auto file = std::ofstream(tmp, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(offsets.data()),
+               offsets.size() * sizeof(uint64_t));
+    file.write(reinterpret_cast<const char*>(keys.data()),
+               keys.size() * sizeof(uint64_t));
+    file.close();
+    if (!file) {
+      throw "write failed";
+    }
+  }
+  if (rename(tmp.c_str(), indexPath(path).c_str()) != 0) {
+    throw "write failed";
+  }
+}
+
+SortedIndex::SortedIndex(const std::string& path)
+{
+  _data = mapFile(path, _dataSize);
+  try {
+    _index =
+      const_cast<char*>(mapFile(indexPath(path), _indexSize));
+  } catch (...) {
+    unmap(_data, _dataSize);
+    throw;
+  }
+  auto header = Header();
+  auto valid = _indexSize >= sizeof(header);
+  if (valid) {
+    memcpy(&header, _index, sizeof(header));
+    auto entries = header.lines + header.keys;
+    valid = memcmp(header.magic, magic, sizeof(magic)) == 0 &&
+            header.fileSize == _dataSize &&
+            header.keys == keyCount(header.lines, header.step) &&
+            _indexSize == sizeof(header) + entries * sizeof(uint64_t);
+  }
+  if (!valid) {
+    unmap(_data, _dataSize);
+    unmap(_index, _indexSize);
+    throw "invalid index";
+  }
+  _lines = header.lines;
+  _step = header.step;
+  _keys = header.keys;
+  auto entries = static_cast<const char*>(_index) + sizeof(header);
+  _offsets = reinterpret_cast<const uint64_t*>(entries);
+  _prefixes = _offsets + _lines;
+}
+
+SortedIndex::~SortedIndex()
+{
+  unmap(_data, _dataSize);
+  unmap(_index, _indexSize);
+}
+
+std::string_view SortedIndex::line(size_t i) const
+{
+  auto begin = _offsets[i];
+  size_t end = _dataSize;
+  if (i + 1 < _lines) {
+    end = _offsets[i + 1] - 1;
+  } else if (_dataSize > 0 && _data[_dataSize - 1] == '\n') {
+    --end;
+  }
+  return std::string_view(_data + begin, end - begin);
+}
+
+size_t SortedIndex::lowerBound(std::string_view key) const
+{
+  size_t first = 0;
+  size_t last = _lines;
+  if (_keys > 0) {
+    // keys that differ are ordered like the lines, so the sampled lines
+    // around the key bound the answer
+    auto k = prefixKey(key.data(), key.size());
+    auto end = _prefixes + _keys;
+    size_t below = std::lower_bound(_prefixes, end, k) - _prefixes;
+    size_t above = std::upper_bound(_prefixes, end, k) - _prefixes;
+    if (below > 0) {
+      first = (below - 1) * _step + 1;
+    }
+    last = std::min<uint64_t>(_lines, above * _step);
+  }
+  while (first < last) {
+    auto mid = first + (last - first) / 2;
+    auto l = line(mid);
+    if (compare(l.data(), l.size(), key.data(), key.size()) < 0) {
+      first = mid + 1;
+    } else {
+      last = mid;
+    }
+  }
+  return first;
+}
+
+std::pair<size_t, size_t> SortedIndex::prefix(std::string_view prefix) const
+{
+  auto first = lowerBound(prefix);
+  // lines cut to the prefix length stay sorted, matches are contiguous
+  size_t low = first;
+  size_t high = _lines;
+  while (low < high) {
+    auto mid = low + (high - low) / 2;
+    auto l = line(mid);
+    auto n = std::min(l.size(), prefix.size());
+    if (compare(l.data(), n, prefix.data(), prefix.size()) <= 0) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return { first, low };
+}
+
+std::pair<size_t, size_t> SortedIndex::range(std::string_view from,
+                                             std::string_view to) const
+{
+  auto first = lowerBound(from);
+  if (to.empty()) {
+    return { first, _lines };
+  }
+  return { first, std::max(first, lowerBound(to)) };
+}
+}
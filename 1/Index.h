@@ -0,0 +1,88 @@
+#ifndef INDEX_H
+#define INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace nonstd
+{
+/**
+ * @brief Sidecar index of a sorted file: 'path' + ".idx"
+ */
+std::string indexPath(const std::string& path);
+
+/**
+ * @brief Write the index of a file sorted like Text::sort() next to it
+ *
+ * @details
+ * The index holds the start offset of every line and, unless 'sparseStep' is
+ * 0, the prefixKey() of every sparseStep-th line. Lines are checked while
+ * indexing, so an unsorted file is never indexed. It is written to a temporary
+ * file and renamed.
+ *
+ * @throw "output not sorted" if a line is less than the one before
+ */
+void buildIndex(const std::string& path, size_t sparseStep = 64);
+
+/**
+ * @brief Sorted file and its index mapped for lookups
+ *
+ * @details
+ * Lookups binary search the line offsets comparing ignoring case, only the
+ * lines probed are read. With a sparse prefix table the search first narrows
+ * to one step of lines by comparing 8-byte keys, without touching the file.
+ */
+class SortedIndex
+{
+public:
+  /**
+   * @brief Map 'path' and indexPath(path)
+   *
+   * @throw "invalid index" if the index is damaged or not of this file
+   */
+  explicit SortedIndex(const std::string& path);
+  SortedIndex(const SortedIndex&) = delete;
+  SortedIndex(SortedIndex&&) = delete;
+  SortedIndex& operator=(const SortedIndex&) = delete;
+  SortedIndex& operator=(SortedIndex&&) = delete;
+  ~SortedIndex();
+
+  size_t size() const
+  {
+    return _lines;
+  }
+
+  std::string_view line(size_t i) const;
+
+  /**
+   * @brief First line not less than 'key'
+   */
+  size_t lowerBound(std::string_view key) const;
+
+  /**
+   * @brief Lines [first, last) starting with 'prefix' ignoring case
+   */
+  std::pair<size_t, size_t> prefix(std::string_view prefix) const;
+
+  /**
+   * @brief Lines [first, last) from 'from' up to but excluding 'to'
+   */
+  std::pair<size_t, size_t> range(std::string_view from,
+                                  std::string_view to) const;
+
+private:
+  const char* _data = nullptr;
+  size_t _dataSize = 0;
+  void* _index = nullptr;
+  size_t _indexSize = 0;
+  uint64_t _lines = 0;
+  uint64_t _step = 0;
+  uint64_t _keys = 0;
+  const uint64_t* _offsets = nullptr;
+  const uint64_t* _prefixes = nullptr;
+};
+}
+
+#endif
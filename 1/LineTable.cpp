@@ -0,0 +1,295 @@
+#include "LineTable.h"
+#include "Compression.h"
+#include "Newlines.h"
+#include "Unique.h"
+
+#include <atomic>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace nonstd
+{
+LineTable::~LineTable()
+{
+  if (_map) {
+    munmap(_map, _mapSize);
+  }
+}
+
+void LineTable::map(const std::string& path, size_t threads)
+{
+  auto fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw "invalid file";
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    throw "invalid file";
+  }
+  _mapSize = st.st_size;
+  if (_mapSize != 0) {
+    _map = mmap(nullptr, _mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (_map == MAP_FAILED) {
+    _map = nullptr;
+    throw "can't map file";
+  }
+  _regions.push_back(Region{ static_cast<char*>(_map), false });
+  if (!_map) {
+    return;
+  }
+
+  madvise(_map, _mapSize, MADV_SEQUENTIAL);
+  _refs = index(static_cast<const char*>(_map), 0, _mapSize, 0, threads);
+  madvise(_map, _mapSize, MADV_NORMAL);
+}
+
+void LineTable::load(const std::string& path, size_t capacity, size_t threads)
+{
+  auto fd = open(path.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    throw "invalid file";
+  }
+  if (detectCompression(path) != Compression::None) {
+    close(fd);
+    auto in = Decompressor(path);
+    // text usually compresses a few times
+    loadFrom([&in](char* data, size_t size) { return in.read(data, size); },
+             st.st_size * 4,
+             capacity,
+             threads);
+    return;
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  try {
+    loadFrom(
+      [fd](char* data, size_t size) {
+        auto n = read(fd, data, size);
+        if (n < 0) {
+          throw "can't read file";
+        }
+        return static_cast<size_t>(n);
+      },
+      st.st_size,
+      capacity,
+      threads);
+  } catch (...) {
+    close(fd);
+    throw;
+  }
+  close(fd);
+}
+
+template<typename Read>
+void LineTable::loadFrom(Read read,
+                         size_t size,
+                         size_t capacity,
+                         size_t threads)
+{
+  // small files don't need a whole arena
+  auto base = allocateChunk(std::min<size_t>(capacity, size + 1));
+  size_t begin = 0;
+  size_t filled = 0;
+  while (true) {
+    if (filled == _chunkCapacity) {
+      // unfinished line moves to the start of a fresh arena
+      auto partial = filled - begin;
+      auto next = allocateChunk(std::max(capacity, partial * 2));
+      memcpy(next, base + begin, partial);
+      base = next;
+      begin = 0;
+      filled = partial;
+    }
+    auto n = read(base + filled, _chunkCapacity - filled);
+    if (n == 0) {
+      break;
+    }
+    auto region = static_cast<uint32_t>(_regions.size() - 1);
+    auto end = filled + n;
+    auto nl = static_cast<const char*>(
+      memrchr(base + filled, '\n', end - filled));
+    if (nl) {
+      auto complete = static_cast<size_t>(nl - base) + 1;
+      auto refs = index(base, begin, complete, region, threads);
+      _refs.insert(_refs.end(), refs.begin(), refs.end());
+      begin = complete;
+    }
+    filled = end;
+  }
+  if (begin < filled) {
+    auto region = static_cast<uint32_t>(_regions.size() - 1);
+    _refs.push_back(
+      LineRef{ begin, static_cast<uint32_t>(filled - begin), region });
+  }
+  _chunkUsed = filled;
+}
+
+std::vector<LineRef> LineTable::index(const char* base,
+                                      size_t begin,
+                                      size_t end,
+                                      uint32_t region,
+                                      size_t threads)
+{
+  // an exception can't leave the indexing threads
+  auto tooLong = std::atomic<bool>(false);
+  auto refs = indexLines<LineRef>(
+    base + begin, end - begin, threads, [&](size_t from, size_t to) {
+      if (to - from > UINT32_MAX) {
+        tooLong = true;
+      }
+      return LineRef{ begin + from, static_cast<uint32_t>(to - from), region };
+    });
+  if (tooLong) {
+    throw "line too long";
+  }
+  return refs;
+}
+
+size_t LineTable::remove(const Pattern& p, size_t threads)
+{
+  return removeWith(p, threads);
+}
+
+size_t LineTable::remove(const PatternSet& p, size_t threads)
+{
+  return removeWith(p, threads);
+}
+
+template<typename Matcher>
+size_t LineTable::removeWith(const Matcher& m, size_t threads)
+{
+  auto writable = [this](const LineRef& r) {
+    return _regions[r.region].writable;
+  };
+  if (!std::all_of(_regions.begin(), _regions.end(), [](const Region& r) {
+        return r.writable;
+      })) {
+    // arena chunks are shared, so only the search runs in parallel
+    auto hits = std::vector<uint8_t>(_refs.size());
+    parallelFor(_refs.size(), threads, [&](size_t begin, size_t end) {
+      for (auto i = begin; i < end; ++i) {
+        const auto& r = _refs[i];
+        hits[i] = !writable(r) &&
+                  m.contains(_regions[r.region].base + r.offset, r.length);
+      }
+    });
+    for (size_t i = 0; i < _refs.size(); ++i) {
+      if (hits[i]) {
+        copyOnWrite(_refs[i]);
+      }
+    }
+  }
+  auto changed = std::atomic<size_t>(0);
+  parallelFor(_refs.size(), threads, [&](size_t begin, size_t end) {
+    size_t count = 0;
+    for (auto i = begin; i < end; ++i) {
+      auto& r = _refs[i];
+      if (writable(r)) {
+        auto length = r.length;
+        r.length = m.removeFrom(_regions[r.region].base + r.offset, length);
+        count += r.length != length;
+      }
+    }
+    changed += count;
+  });
+  return changed;
+}
+
+char* LineTable::copyOnWrite(LineRef& r)
+{
+  if (_chunks.empty() || _chunkCapacity - _chunkUsed < r.length) {
+    allocateChunk(std::max<size_t>(chunkSize, r.length));
+  }
+  auto data = _chunks.back().get() + _chunkUsed;
+  memcpy(data, _regions[r.region].base + r.offset, r.length);
+  auto region = static_cast<uint32_t>(_regions.size() - 1);
+  r = LineRef{ _chunkUsed, r.length, region };
+  _chunkUsed += r.length;
+  ++_copied;
+  return data;
+}
+
+char* LineTable::allocateChunk(size_t capacity)
+{
+  _chunks.emplace_back(new char[capacity]);
+  _regions.push_back(Region{ _chunks.back().get(), true });
+  _chunkCapacity = capacity;
+  _chunkUsed = 0;
+  return _chunks.back().get();
+}
+
+void LineTable::sort(size_t threads, SortAlgorithm algorithm)
+{
+  sortLines(_refs, threads, algorithm, [this](const LineRef& r) {
+    return std::string_view(_regions[r.region].base + r.offset, r.length);
+  });
+}
+
+void LineTable::unique()
+{
+  uniqueLines(_refs, [this](const LineRef& r) {
+    return std::string_view(_regions[r.region].base + r.offset, r.length);
+  });
+}
+
+void LineTable::sortFirst(size_t count)
+{
+  sortFirstLines(_refs, count, [this](const LineRef& r) {
+    return std::string_view(_regions[r.region].base + r.offset, r.length);
+  });
+}
+
+void LineTable::keepRange(std::string_view from, std::string_view to)
+{
+  nonstd::keepRange(_refs, from, to, [this](const LineRef& r) {
+    return std::string_view(_regions[r.region].base + r.offset, r.length);
+  });
+}
+
+void LineTable::write(Writer& out) const
+{
+  for (size_t i = 0; i < _refs.size(); ++i) {
+    out.line(line(i));
+  }
+}
+
+size_t LineTable::removeAndWrite(const Pattern& p, Writer& out)
+{
+  return removeAndWriteWith(p, out);
+}
+
+size_t LineTable::removeAndWrite(const PatternSet& p, Writer& out)
+{
+  return removeAndWriteWith(p, out);
+}
+
+template<typename Matcher>
+size_t LineTable::removeAndWriteWith(const Matcher& m, Writer& out)
+{
+  size_t changed = 0;
+  for (auto& r : _refs) {
+    auto data = _regions[r.region].base + r.offset;
+    if (!_regions[r.region].writable) {
+      if (!m.contains(data, r.length)) {
+        out.line(std::string_view(data, r.length));
+        continue;
+      }
+      data = copyOnWrite(r);
+    }
+    auto length = r.length;
+    r.length = m.removeFrom(data, length);
+    changed += r.length != length;
+    out.line(std::string_view(data, r.length));
+  }
+  return changed;
+}
+}
@@ -0,0 +1,151 @@
+#ifndef LINE_TABLE_H
+#define LINE_TABLE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Pattern.h"
+#include "PatternSet.h"
+#include "Sort.h"
+#include "Writer.h"
+
+namespace nonstd
+{
+/**
+ * @brief Compact handle of a line: 'length' bytes at 'offset' of 'region'
+ */
+struct LineRef
+{
+  uint64_t offset;
+  uint32_t length;
+  uint32_t region;
+};
+
+/**
+ * @brief Lines kept as compact handles into a few large byte regions
+ *
+ * @details
+ * Regions are either a read-only memory mapped file (map()) or owned arenas
+ * the file is read into (load()). Mapped lines are copied into an arena the
+ * first time remove() changes them, arena lines are edited in place. sort()
+ * only moves the handles.
+ */
+class LineTable
+{
+public:
+  static constexpr size_t chunkSize = 1024 * 1024;
+  static constexpr size_t arenaSize = 16 * 1024 * 1024;
+
+  LineTable() = default;
+  LineTable(const LineTable&) = delete;
+  LineTable(LineTable&&) = delete;
+  LineTable& operator=(const LineTable&) = delete;
+  LineTable& operator=(LineTable&&) = delete;
+  ~LineTable();
+
+  /**
+   * @brief Map file and index its lines
+   *
+   * @param path file to map
+   * @param threads number of threads indexing lines
+   */
+  void map(const std::string& path, size_t threads = 1);
+
+  /**
+   * @brief Read file into arenas and index its lines
+   *
+   * @details
+   * Compressed files are decompressed on another thread while lines of the
+   * previous blocks are indexed.
+   *
+   * @param path file to read
+   * @param capacity arena size, lines longer than it get a bigger arena
+   * @param threads number of threads indexing lines of every arena
+   */
+  void load(const std::string& path,
+            size_t capacity = arenaSize,
+            size_t threads = 1);
+
+  size_t size() const
+  {
+    return _refs.size();
+  }
+
+  std::string_view line(size_t i) const
+  {
+    const auto& r = _refs[i];
+    return std::string_view(_regions[r.region].base + r.offset, r.length);
+  }
+
+  /**
+   * @brief Number of lines copied out of the mapping
+   */
+  size_t copied() const
+  {
+    return _copied;
+  }
+
+  /**
+   * @brief Remove pattern from every line
+   *
+   * @return number of lines it changed
+   */
+  size_t remove(const Pattern& p, size_t threads = 1);
+  size_t remove(const PatternSet& p, size_t threads = 1);
+  void sort(size_t threads = 1,
+            SortAlgorithm algorithm = SortAlgorithm::Comparison);
+  void unique();
+
+  /**
+   * @brief Keep the first 'count' lines of sort() order, see sortFirstLines()
+   */
+  void sortFirst(size_t count);
+
+  /**
+   * @brief Drop lines outside [from, to) ignoring case, see keepRange()
+   */
+  void keepRange(std::string_view from, std::string_view to);
+  void write(Writer& out) const;
+
+  /**
+   * @brief remove() and write() in one pass over the lines
+   */
+  size_t removeAndWrite(const Pattern& p, Writer& out);
+  size_t removeAndWrite(const PatternSet& p, Writer& out);
+
+private:
+  struct Region
+  {
+    char* base;
+    bool writable;
+  };
+
+  template<typename Read>
+  void loadFrom(Read read, size_t size, size_t capacity, size_t threads);
+  std::vector<LineRef> index(const char* base,
+                             size_t begin,
+                             size_t end,
+                             uint32_t region,
+                             size_t threads);
+  template<typename Matcher>
+  size_t removeWith(const Matcher& m, size_t threads);
+  template<typename Matcher>
+  size_t removeAndWriteWith(const Matcher& m, Writer& out);
+  char* copyOnWrite(LineRef& r);
+  char* allocateChunk(size_t capacity);
+
+  std::vector<LineRef> _refs;
+  std::vector<Region> _regions;
+  std::vector<std::unique_ptr<char[]>> _chunks;
+  size_t _chunkUsed = 0;
+  size_t _chunkCapacity = 0;
+  size_t _copied = 0;
+  void* _map = nullptr;
+  size_t _mapSize = 0;
+};
+}
+
+#endif
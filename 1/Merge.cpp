@@ -0,0 +1,183 @@
+#include "Merge.h"
+#include "PatternSet.h"
+#include "Text.h"
+
+namespace nonstd
+{
+namespace
+{
+/**
+ * @brief Tournament over run heads, internal nodes keep the loser of a match
+ *
+ * @details
+ * Leaf i is node size + i, so a new head of the winning run only replays the
+ * matches on its path to the root. Exhausted runs lose every match.
+ */
+class LoserTree
+{
+public:
+  explicit LoserTree(const std::vector<string>& heads) :
+    _heads(heads),
+    _done(heads.size(), false),
+    _nodes(std::max<size_t>(1, heads.size()))
+  {
+  }
+
+  void build()
+  {
+    auto size = _heads.size();
+    if (size == 0) {
+      return;
+    }
+    auto winners = std::vector<size_t>(2 * size);
+    for (size_t i = 0; i < size; ++i) {
+      winners[size + i] = i;
+    }
+    for (auto n = size - 1; n > 0; --n) {
+      auto a = winners[2 * n];
+      auto b = winners[2 * n + 1];
+      winners[n] = beats(a, b) ? a : b;
+      _nodes[n] = beats(a, b) ? b : a;
+    }
+    _nodes[0] = winners[1];
+  }
+
+  /**
+   * @brief Mark a run empty before build()
+   */
+  void exclude(size_t run)
+  {
+    _done[run] = true;
+  }
+
+  bool empty() const
+  {
+    return _heads.empty() || _done[_nodes[0]];
+  }
+
+  size_t winner() const
+  {
+    return _nodes[0];
+  }
+
+  /**
+   * @brief Replay after the head of the winner changed or its run ended
+   */
+  void replay(bool done)
+  {
+    auto w = _nodes[0];
+    _done[w] = done;
+    for (auto n = (_heads.size() + w) / 2; n > 0; n /= 2) {
+      if (beats(_nodes[n], w)) {
+        std::swap(_nodes[n], w);
+      }
+    }
+    _nodes[0] = w;
+  }
+
+private:
+  // equal lines are taken from the earlier run first to keep the sort stable
+  bool beats(size_t a, size_t b) const
+  {
+    if (_done[a] || _done[b]) {
+      return !_done[a];
+    }
+    auto c = _heads[a].compare(_heads[b]);
+    return c < 0 || (c == 0 && a < b);
+  }
+
+  const std::vector<string>& _heads;
+  std::vector<bool> _done;
+  std::vector<size_t> _nodes;
+};
+
+void merge(const std::vector<std::string>& runs,
+           Writer& out,
+           bool unique,
+           size_t skip,
+           const PatternSet* patterns,
+           bool check)
+{
+  auto inputs = std::vector<std::ifstream>();
+  auto heads = std::vector<string>(runs.size());
+  auto tree = LoserTree(heads);
+  std::string tmp;
+  // patterns go before the tree, so it orders and compares what is written
+  auto next = [&](size_t i) {
+    if (!std::getline(inputs[i], tmp)) {
+      return false;
+    }
+    if (patterns) {
+      tmp.resize(patterns->removeFrom(&tmp[0], tmp.size()));
+    }
+    return true;
+  };
+  for (size_t i = 0; i < runs.size(); ++i) {
+    inputs.emplace_back(runs[i]);
+    if (check && !inputs[i].good()) {
+      throw "invalid file";
+    }
+    if (next(i)) {
+      heads[i].assign(tmp.data(), tmp.size());
+    } else {
+      tree.exclude(i);
+    }
+  }
+  tree.build();
+  auto last = string();
+  auto first = true;
+  while (!tree.empty()) {
+    auto i = tree.winner();
+    auto& head = heads[i];
+    if (!unique || first || head.compare(last) != 0) {
+      out.line(std::string_view(head.data(), head.size()).substr(skip));
+      if (unique) {
+        last = head;
+        first = false;
+      }
+    }
+    if (!next(i)) {
+      tree.replay(true);
+      continue;
+    }
+    if (check &&
+        head.compare(0, head.size(), tmp.data(), tmp.size()) > 0) {
+      throw "input not sorted";
+    }
+    head.assign(tmp.data(), tmp.size());
+    tree.replay(false);
+  }
+}
+}
+
+void mergeRuns(const std::vector<std::string>& runs,
+               Writer& out,
+               bool unique,
+               size_t skip)
+{
+  merge(runs, out, unique, skip, nullptr, false);
+}
+
+void mergeSorted(const std::vector<std::string>& inputs,
+                 const std::string& output,
+                 const std::vector<std::string>& patterns,
+                 bool unique,
+                 bool ignoreCase)
+{
+  auto set = PatternSet(patterns, ignoreCase);
+  if (!AtomicFile::replaceable(output)) {
+    auto out = Writer(output);
+    merge(inputs, out, unique, 0, set.empty() ? nullptr : &set, true);
+    out.close();
+    return;
+  }
+  // an input may be the output too, it is replaced only after the merge
+  auto file = AtomicFile(output);
+  {
+    auto out = Writer(file.temporary());
+    merge(inputs, out, unique, 0, set.empty() ? nullptr : &set, true);
+    out.close();
+  }
+  file.commit(false);
+}
+}
@@ -0,0 +1,47 @@
+#ifndef MERGE_H
+#define MERGE_H
+
+#include <string>
+#include <vector>
+
+#include "Writer.h"
+
+namespace nonstd
+{
+class PatternSet;
+
+/**
+ * @brief k-way merge of sorted runs
+ *
+ * @details
+ * Run heads are kept in a loser tree, every line output costs log2(runs)
+ * comparisons and memory is one line per run. With 'unique' a line equal to
+ * the previous output line is dropped, the kept one comes from the earliest
+ * run. The first 'skip' bytes of every line are a sort key only and are not
+ * written.
+ */
+void mergeRuns(const std::vector<std::string>& runs,
+               Writer& out,
+               bool unique = false,
+               size_t skip = 0);
+
+/**
+ * @brief Merge files each sorted like Text::sort() into 'output'
+ *
+ * @details
+ * 'patterns' are removed from every line as it is read, then lines are merged
+ * and made unique if asked, which gives what removing, sorting and unique on
+ * their concatenation would. 'output' is replaced only once the merge is
+ * done, so it may be one of the inputs.
+ *
+ * @throw "input not sorted" if a line of an input, patterns removed, is less
+ * than the one before
+ */
+void mergeSorted(const std::vector<std::string>& inputs,
+                 const std::string& output,
+                 const std::vector<std::string>& patterns = {},
+                 bool unique = false,
+                 bool ignoreCase = false);
+}
+
+#endif
@@ -0,0 +1,60 @@
+#include "Newlines.h"
+
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace nonstd
+{
+size_t findNewlines(const char* data, size_t size, uint32_t* out)
+{
+  size_t count = 0;
+  size_t i = 0;
+#if defined(__AVX2__)
+  auto newline32 = _mm256_set1_epi8('\n');
+  for (; i + 32 <= size; i += 32) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, newline32));
+    for (; mask != 0; mask &= mask - 1) {
+      out[count++] = i + __builtin_ctz(mask);
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  auto newline16 = _mm_set1_epi8('\n');
+  for (; i + 16 <= size; i += 16) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, newline16));
+    for (; mask != 0; mask &= mask - 1) {
+      out[count++] = i + __builtin_ctz(mask);
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    if (data[i] == '\n') {
+      out[count++] = i;
+    }
+  }
+  return count;
+}
+
+std::vector<size_t> lineAlignedCuts(const char* data,
+                                    size_t size,
+                                    size_t parts)
+{
+  auto cuts = std::vector<size_t>{ 0 };
+  for (size_t p = 1; p < parts; ++p) {
+    auto cut = std::max(size / parts * p, cuts.back());
+    if (cut > 0 && cut < size && data[cut - 1] != '\n') {
+      auto nl =
+        static_cast<const char*>(memchr(data + cut, '\n', size - cut));
+      cut = nl ? nl - data + 1 : size;
+    }
+    cuts.push_back(cut);
+  }
+  cuts.push_back(size);
+  return cuts;
+}
+}
@@ -0,0 +1,101 @@
+#ifndef NEWLINES_H
+#define NEWLINES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Parallel.h"
+
+namespace nonstd
+{
+/**
+ * @brief Write offsets of all '\n' of data to 'out', return their count
+ *
+ * @details
+ * 'out' needs room for 'size' offsets and size must be below 4 GiB. Compares
+ * 32 (AVX2) or 16 (SSE2) bytes at once when the build targets them and walks
+ * the resulting bit mask, the tail is scanned byte by byte.
+ */
+size_t findNewlines(const char* data, size_t size, uint32_t* out);
+
+/**
+ * @brief Call f(begin, end) for every line of data, 'end' at its newline
+ *
+ * @details
+ * Gives the lines std::getline() does: a last line without newline is
+ * included, nothing follows a final newline.
+ */
+template<typename F>
+void forEachLine(const char* data, size_t size, F f)
+{
+  const size_t slice = 64 * 1024;
+  auto newlines = std::vector<uint32_t>(std::min(slice, size));
+  size_t begin = 0;
+  for (size_t at = 0; at < size; at += slice) {
+    auto count =
+      findNewlines(data + at, std::min(slice, size - at), newlines.data());
+    for (size_t i = 0; i < count; ++i) {
+      size_t end = at + newlines[i];
+      f(begin, end);
+      begin = end + 1;
+    }
+  }
+  if (begin < size) {
+    f(begin, size);
+  }
+}
+
+/**
+ * @brief Cut data into 'parts' ranges, every one starting at a line start
+ *
+ * @return parts + 1 offsets from 0 to size, ranges may be empty
+ */
+std::vector<size_t> lineAlignedCuts(const char* data,
+                                    size_t size,
+                                    size_t parts);
+
+/**
+ * @brief Lines of data made by make(begin, end), indexed on 'threads' threads
+ *
+ * @details
+ * Every thread indexes a range of lineAlignedCuts() into its own vector, they
+ * are concatenated in order, so the result doesn't depend on 'threads'.
+ */
+template<typename T, typename Make>
+std::vector<T> indexLines(const char* data,
+                          size_t size,
+                          size_t threads,
+                          Make make)
+{
+  // splitting small inputs costs more than it saves
+  const size_t minPart = 1024 * 1024;
+  threads = std::max<size_t>(1, std::min(threads, size / minPart));
+  auto cuts = lineAlignedCuts(data, size, threads);
+  auto parts = std::vector<std::vector<T>>(threads);
+  parallelFor(threads, threads, [&](size_t first, size_t last) {
+    for (auto t = first; t < last; ++t) {
+      auto offset = cuts[t];
+      forEachLine(
+        data + offset, cuts[t + 1] - offset, [&](size_t begin, size_t end) {
+          parts[t].push_back(make(offset + begin, offset + end));
+        });
+    }
+  });
+  if (threads == 1) {
+    return std::move(parts[0]);
+  }
+  size_t total = 0;
+  for (const auto& p : parts) {
+    total += p.size();
+  }
+  auto result = std::vector<T>();
+  result.reserve(total);
+  for (auto& p : parts) {
+    std::move(p.begin(), p.end(), std::back_inserter(result));
+  }
+  return result;
+}
+}
+
+#endif
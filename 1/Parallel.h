@@ -0,0 +1,100 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+namespace nonstd
+{
+/**
+ * @brief Call f(begin, end) for 'threads' contiguous ranges of [0, count)
+ *
+ * @details
+ * The calling thread takes the first range. With one thread (or too little
+ * work to split) f is simply called for the whole range.
+ */
+template<typename F>
+void parallelFor(size_t count, size_t threads, F f)
+{
+  threads = std::max<size_t>(1, std::min(threads, count));
+  if (threads == 1) {
+    f(size_t(0), count);
+    return;
+  }
+  auto workers = std::vector<std::thread>();
+  auto step = count / threads;
+  auto rest = count % threads;
+  size_t begin = step + (rest > 0);
+  for (size_t t = 1; t < threads; ++t) {
+    auto end = begin + step + (t < rest);
+    workers.emplace_back(f, begin, end);
+    begin = end;
+  }
+  f(size_t(0), step + (rest > 0));
+  for (auto& w : workers) {
+    w.join();
+  }
+}
+
+/**
+ * @brief Stable sort on 'threads' threads
+ *
+ * @details
+ * Every thread stable sorts its own range, then neighbouring ranges are merged
+ * pairwise, the left one first on ties, in log2(threads) parallel rounds. The
+ * result is exactly that of std::stable_sort.
+ */
+template<typename T, typename Less>
+void parallelStableSort(std::vector<T>& v, size_t threads, Less less)
+{
+  threads = std::max<size_t>(1, std::min(threads, v.size() / 1024));
+  if (threads == 1) {
+    std::stable_sort(v.begin(), v.end(), less);
+    return;
+  }
+  parallelFor(v.size(), threads, [&v, &less](size_t begin, size_t end) {
+    std::stable_sort(v.begin() + begin, v.begin() + end, less);
+  });
+  // same split as parallelFor
+  auto bounds = std::vector<size_t>();
+  for (size_t t = 0; t <= threads; ++t) {
+    bounds.push_back(v.size() / threads * t + std::min(t, v.size() % threads));
+  }
+
+  auto buffer = std::vector<T>(v.size());
+  auto* from = &v;
+  auto* to = &buffer;
+  while (bounds.size() > 2) {
+    auto merged = std::vector<size_t>();
+    auto pairs = bounds.size() / 2;
+    parallelFor(pairs, pairs, [&](size_t first, size_t last) {
+      for (auto p = first; p < last; ++p) {
+        auto begin = bounds[2 * p];
+        auto middle = bounds[std::min(2 * p + 1, bounds.size() - 1)];
+        auto end = bounds[std::min(2 * p + 2, bounds.size() - 1)];
+        std::merge(std::make_move_iterator(from->begin() + begin),
+                   std::make_move_iterator(from->begin() + middle),
+                   std::make_move_iterator(from->begin() + middle),
+                   std::make_move_iterator(from->begin() + end),
+                   to->begin() + begin,
+                   less);
+      }
+    });
+    for (size_t i = 0; i < bounds.size(); i += 2) {
+      merged.push_back(bounds[i]);
+    }
+    if (merged.back() != bounds.back()) {
+      merged.push_back(bounds.back());
+    }
+    bounds = merged;
+    std::swap(from, to);
+  }
+  if (from != &v) {
+    v = std::move(buffer);
+  }
+}
+}
+
+#endif
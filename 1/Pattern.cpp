@@ -0,0 +1,60 @@
+#include "Pattern.h"
+#include "CaseFold.h"
+
+#include <string.h>
+
+namespace nonstd
+{
+Pattern::Pattern(const std::string& literal, bool ignoreCase) :
+  _literal(literal), _ignoreCase(ignoreCase)
+{
+  _shift.fill(_literal.size());
+  for (size_t i = 0; i + 1 < _literal.size(); ++i) {
+    _shift[static_cast<unsigned char>(_literal[i])] = _literal.size() - 1 - i;
+  }
+}
+
+size_t Pattern::find(const char* data, size_t size, size_t from) const
+{
+  auto m = _literal.size();
+  if (m == 0 || from > size || size - from < m) {
+    return npos;
+  }
+  if (_ignoreCase) {
+    auto hit = findFolded(data + from, size - from, _literal.data(), m);
+    return hit == SIZE_MAX ? npos : from + hit;
+  }
+  if (m == 1) {
+    auto p = static_cast<const char*>(
+      memchr(data + from, _literal[0], size - from));
+    return p ? p - data : npos;
+  }
+  auto last = m - 1;
+  auto tail = _literal[last];
+  for (auto i = from; i + m <= size;) {
+    auto c = data[i + last];
+    if (c == tail && memcmp(data + i, _literal.data(), last) == 0) {
+      return i;
+    }
+    i += _shift[static_cast<unsigned char>(c)];
+  }
+  return npos;
+}
+
+size_t Pattern::removeFrom(char* data, size_t size) const
+{
+  auto hit = find(data, size);
+  if (hit == npos) {
+    return size;
+  }
+  size_t out = hit;
+  size_t pos = hit + _literal.size();
+  while ((hit = find(data, size, pos)) != npos) {
+    memmove(data + out, data + pos, hit - pos);
+    out += hit - pos;
+    pos = hit + _literal.size();
+  }
+  memmove(data + out, data + pos, size - pos);
+  return out + size - pos;
+}
+}
@@ -0,0 +1,68 @@
+#ifndef PATTERN_H
+#define PATTERN_H
+
+#include <array>
+#include <string>
+
+namespace nonstd
+{
+/**
+ * @brief Literal pattern compiled once and matched many times
+ *
+ * @details
+ * Uses Boyer-Moore-Horspool: the bad character table lets the search skip up
+ * to size() bytes per probe. Matches are found left to right and never
+ * overlap, which is what std::regex_replace of an escaped literal does.
+ *
+ * A pattern ignoring case matches every ASCII case variant of the literal,
+ * it is searched with findFolded() instead.
+ */
+class Pattern
+{
+public:
+  static constexpr size_t npos = std::string::npos;
+
+  explicit Pattern(const std::string& literal, bool ignoreCase = false);
+
+  /**
+   * @brief Find first occurrence starting at 'from'
+   *
+   * @return position of occurrence or npos
+   */
+  size_t find(const char* data, size_t size, size_t from = 0) const;
+
+  bool contains(const char* data, size_t size) const
+  {
+    return find(data, size) != npos;
+  }
+
+  /**
+   * @brief Remove every occurrence in place
+   *
+   * @return new size of data, never larger than 'size'
+   */
+  size_t removeFrom(char* data, size_t size) const;
+
+  const std::string& literal() const
+  {
+    return _literal;
+  }
+
+  size_t size() const
+  {
+    return _literal.size();
+  }
+
+  bool ignoresCase() const
+  {
+    return _ignoreCase;
+  }
+
+private:
+  std::string _literal;
+  bool _ignoreCase;
+  std::array<size_t, 256> _shift;
+};
+}
+
+#endif
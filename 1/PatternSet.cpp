@@ -0,0 +1,162 @@
+#include "PatternSet.h"
+#include "CaseFold.h"
+
+#include <algorithm>
+#include <queue>
+#include <string.h>
+
+namespace nonstd
+{
+PatternSet::PatternSet(const std::vector<std::string>& literals,
+                       bool ignoreCase)
+{
+  for (const auto& l : literals) {
+    if (!l.empty()) {
+      _patterns.emplace_back(l, ignoreCase);
+      if (_shortest == 0 || l.size() < _shortest) {
+        _shortest = l.size();
+      }
+    }
+  }
+
+  _class.fill(0);
+  for (const auto& p : _patterns) {
+    for (auto c : p.literal()) {
+      auto byte = static_cast<unsigned char>(c);
+      if (ignoreCase) {
+        byte = fold(byte);
+      }
+      auto& cls = _class[byte];
+      if (cls == 0) {
+        cls = _classes++;
+        if (ignoreCase && byte >= 'a' && byte <= 'z') {
+          _class[byte - 'a' + 'A'] = cls;
+        }
+      }
+    }
+  }
+
+  // trie
+  const uint32_t none = UINT32_MAX;
+  _next.assign(_classes, none);
+  _first.assign(1, npos);
+  for (size_t i = 0; i < _patterns.size(); ++i) {
+    uint32_t state = 0;
+    for (auto c : _patterns[i].literal()) {
+      auto edge = state * _classes + _class[static_cast<unsigned char>(c)];
+      if (_next[edge] == none) {
+        _next[edge] = _first.size();
+        _next.resize(_next.size() + _classes, none);
+        _first.push_back(npos);
+      }
+      state = _next[edge];
+    }
+    _first[state] = std::min(_first[state], i);
+    _ends.resize(_first.size());
+    _ends[state].push_back(i);
+  }
+  _ends.resize(_first.size());
+
+  // failure links folded into a dense transition table
+  auto fail = std::vector<uint32_t>(_first.size(), 0);
+  _suffix.assign(_first.size(), 0);
+  auto queue = std::queue<uint32_t>();
+  for (size_t c = 0; c < _classes; ++c) {
+    auto& next = _next[c];
+    if (next == none) {
+      next = 0;
+    } else {
+      queue.push(next);
+    }
+  }
+  while (!queue.empty()) {
+    auto state = queue.front();
+    queue.pop();
+    _first[state] = std::min(_first[state], _first[fail[state]]);
+    for (size_t c = 0; c < _classes; ++c) {
+      auto& next = _next[state * _classes + c];
+      auto fallback = _next[fail[state] * _classes + c];
+      if (next == none) {
+        next = fallback;
+      } else {
+        fail[next] = fallback;
+        _suffix[next] = _ends[fallback].empty() ? _suffix[fallback] : fallback;
+        queue.push(next);
+      }
+    }
+  }
+}
+
+size_t PatternSet::firstMatch(const char* data, size_t size) const
+{
+  if (size < _shortest || _patterns.empty()) {
+    return npos;
+  }
+  size_t best = npos;
+  uint32_t state = 0;
+  for (size_t i = 0; i < size && best != 0; ++i) {
+    auto c = _class[static_cast<unsigned char>(data[i])];
+    state = _next[state * _classes + c];
+    best = std::min(best, _first[state]);
+  }
+  return best;
+}
+
+size_t PatternSet::firstEndingAt(uint32_t state, size_t from) const
+{
+  if (_first[state] >= from) {
+    return _first[state];
+  }
+  auto best = npos;
+  for (; state != 0; state = _suffix[state]) {
+    const auto& ends = _ends[state];
+    auto it = std::lower_bound(ends.begin(), ends.end(), from);
+    if (it != ends.end()) {
+      best = std::min(best, *it);
+    }
+  }
+  return best;
+}
+
+size_t PatternSet::removeFrom(char* data, size_t size) const
+{
+  auto hits = std::vector<size_t>();
+  for (size_t from = 0; from < _patterns.size() && size >= _shortest;) {
+    // one scan finds the lowest pattern from 'from' on and where it starts
+    auto best = npos;
+    size_t length = 0;
+    uint32_t state = 0;
+    for (size_t i = 0; i < size; ++i) {
+      auto c = _class[static_cast<unsigned char>(data[i])];
+      state = _next[state * _classes + c];
+      auto match = firstEndingAt(state, from);
+      if (match > best) {
+        continue;
+      }
+      if (match < best) {
+        best = match;
+        length = _patterns[best].literal().size();
+        hits.clear();
+      }
+      // left to right without overlaps, like Pattern::removeFrom()
+      auto start = i + 1 - length;
+      if (hits.empty() || start >= hits.back() + length) {
+        hits.push_back(start);
+      }
+    }
+    if (best == npos) {
+      break;
+    }
+    size_t out = hits[0];
+    for (size_t h = 0; h < hits.size(); ++h) {
+      auto pos = hits[h] + length;
+      auto end = h + 1 < hits.size() ? hits[h + 1] : size;
+      memmove(data + out, data + pos, end - pos);
+      out += end - pos;
+    }
+    size = out;
+    from = best + 1;
+  }
+  return size;
+}
+}
@@ -0,0 +1,91 @@
+#ifndef PATTERN_SET_H
+#define PATTERN_SET_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "Pattern.h"
+
+namespace nonstd
+{
+/**
+ * @brief Ordered set of literal patterns removed as if one after another
+ *
+ * @details
+ * An Aho-Corasick automaton over the patterns finds, in a single scan, the
+ * first pattern (in set order) that occurs in a line and every place it
+ * occurs. Lines without any occurrence are left untouched after that scan.
+ * Otherwise those places are cut out and the scan repeats for the patterns
+ * after it only: the ones before can't match until something is removed, so
+ * the result is exactly that of removing every pattern in sequence, with one
+ * scan per pattern that occurs. Lines shorter than the shortest pattern
+ * aren't scanned at all.
+ *
+ * Ignoring case, both cases of a letter share a byte class, so the automaton
+ * matches every case variant at no extra cost.
+ */
+class PatternSet
+{
+public:
+  static constexpr size_t npos = std::string::npos;
+
+  explicit PatternSet(const std::vector<std::string>& literals,
+                      bool ignoreCase = false);
+
+  /**
+   * @brief Find the lowest index of a pattern occurring in data
+   *
+   * @return pattern index or npos
+   */
+  size_t firstMatch(const char* data, size_t size) const;
+
+  bool contains(const char* data, size_t size) const
+  {
+    return firstMatch(data, size) != npos;
+  }
+
+  /**
+   * @brief Remove every pattern in set order, in place
+   *
+   * @return new size of data, never larger than 'size'
+   */
+  size_t removeFrom(char* data, size_t size) const;
+
+  bool empty() const
+  {
+    return _patterns.empty();
+  }
+
+  size_t size() const
+  {
+    return _patterns.size();
+  }
+
+  /**
+   * @brief Length of the shortest pattern, lines below it can't match
+   */
+  size_t shortest() const
+  {
+    return _shortest;
+  }
+
+private:
+  // lowest index from 'from' on of the patterns ending in 'state'
+  size_t firstEndingAt(uint32_t state, size_t from) const;
+
+  std::vector<Pattern> _patterns;
+  // bytes which don't occur in any pattern share class 0
+  std::array<uint16_t, 256> _class;
+  size_t _classes = 1;
+  std::vector<uint32_t> _next;
+  std::vector<size_t> _first;
+  // patterns spelled by a state, in set order
+  std::vector<std::vector<size_t>> _ends;
+  // longest proper suffix state spelling a pattern, 0 if none
+  std::vector<uint32_t> _suffix;
+  size_t _shortest = 0;
+};
+}
+
+#endif
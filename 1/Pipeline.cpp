@@ -0,0 +1,258 @@
+#include "Pipeline.h"
+#include "Queue.h"
+
+#include <exception>
+#include <fcntl.h>
+#include <mutex>
+#include <string.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace nonstd
+{
+namespace
+{
+using Batches = BoundedQueue<std::string>;
+
+struct File
+{
+  File(const std::string& path, int flags) :
+    fd(open(path.c_str(), flags | O_CLOEXEC, 0644))
+  {}
+  File(const File&) = delete;
+  File& operator=(const File&) = delete;
+  ~File()
+  {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+
+  int fd;
+};
+
+void readBatches(int fd,
+                 uint64_t size,
+                 const PipelineOptions& options,
+                 Batches& free,
+                 Batches& filled)
+{
+  const uint64_t blockSize = options.blockSize;
+  auto blocks = (size + blockSize - 1) / blockSize;
+  auto length = [&](uint64_t b) {
+    return std::min(blockSize, size - b * blockSize);
+  };
+  // block b is read into raw[b % 2] while block b - 1 is cut
+  std::vector<char> raw[2] = { std::vector<char>(blockSize),
+                               std::vector<char>(blockSize) };
+  uint64_t got[2] = { 0, 0 };
+  auto io = AsyncIo(options.backend, 2);
+  auto request = [&](uint64_t b) {
+    auto slot = b % 2;
+    io.read(fd,
+            raw[slot].data() + got[slot],
+            length(b) - got[slot],
+            b * blockSize + got[slot],
+            b);
+  };
+  for (uint64_t b = 0; b < std::min<uint64_t>(2, blocks); ++b) {
+    request(b);
+  }
+
+  auto carry = std::string();
+  auto batch = std::string();
+  for (uint64_t b = 0; b < blocks; ++b) {
+    auto slot = b % 2;
+    while (got[slot] < length(b)) {
+      auto done = io.wait();
+      if (done.result <= 0) {
+        throw "read failed";
+      }
+      got[done.tag % 2] += done.result;
+      if (got[done.tag % 2] < length(done.tag)) {
+        request(done.tag);
+      }
+    }
+    const auto* data = raw[slot].data();
+    auto* last = static_cast<const char*>(memrchr(data, '\n', length(b)));
+    if (!last) {
+      carry.append(data, length(b));
+    } else {
+      if (!free.pop(batch)) {
+        return;
+      }
+      auto cut = last - data + 1;
+      batch.assign(carry);
+      batch.append(data, cut);
+      carry.assign(data + cut, length(b) - cut);
+      filled.push(std::move(batch));
+    }
+    got[slot] = 0;
+    if (b + 2 < blocks) {
+      request(b + 2);
+    }
+  }
+  if (!carry.empty() && free.pop(batch)) {
+    batch.assign(carry);
+    batch.push_back('\n');
+    filled.push(std::move(batch));
+  }
+}
+
+// every line of 'batch' ends with a newline
+void edit(std::string& batch, const PatternSet& patterns)
+{
+  auto* data = &batch[0];
+  size_t out = 0;
+  size_t pos = 0;
+  while (pos < batch.size()) {
+    auto end = static_cast<char*>(memchr(data + pos, '\n', batch.size() - pos));
+    auto length = patterns.removeFrom(data + pos, end - (data + pos));
+    if (out != pos) {
+      memmove(data + out, data + pos, length);
+    }
+    out += length;
+    data[out++] = '\n';
+    pos = end - data + 1;
+  }
+  batch.resize(out);
+}
+
+void writeBatches(int fd,
+                  const PipelineOptions& options,
+                  Batches& free,
+                  Batches& edited)
+{
+  struct Slot
+  {
+    std::string data;
+    size_t done;
+    uint64_t offset;
+  };
+  // one batch is always outside the writer, or the reader could starve
+  auto depth = static_cast<unsigned>(options.batches - 1);
+  auto slots = std::vector<Slot>(depth);
+  auto idle = std::vector<uint64_t>();
+  for (unsigned i = 0; i < depth; ++i) {
+    idle.push_back(i);
+  }
+  auto io = AsyncIo(options.backend, depth);
+  auto complete = [&] {
+    auto done = io.wait();
+    if (done.result <= 0) {
+      throw "write failed";
+    }
+    auto& s = slots[done.tag];
+    s.done += done.result;
+    if (s.done < s.data.size()) {
+      io.write(fd,
+               s.data.data() + s.done,
+               s.data.size() - s.done,
+               s.offset + s.done,
+               done.tag);
+    } else {
+      free.push(std::move(s.data));
+      idle.push_back(done.tag);
+    }
+  };
+
+  uint64_t offset = 0;
+  auto batch = std::string();
+  while (edited.pop(batch)) {
+    if (batch.empty()) {
+      free.push(std::move(batch));
+      continue;
+    }
+    while (idle.empty()) {
+      complete();
+    }
+    auto tag = idle.back();
+    idle.pop_back();
+    auto size = batch.size();
+    slots[tag] = Slot{ std::move(batch), 0, offset };
+    io.write(fd, slots[tag].data.data(), size, offset, tag);
+    offset += size;
+  }
+  while (io.pending() > 0) {
+    complete();
+  }
+}
+}
+
+void filterLines(const std::string& from,
+                 const std::string& to,
+                 const PatternSet& patterns,
+                 const PipelineOptions& options)
+{
+  if (options.blockSize == 0 || options.batches < 2) {
+    throw "invalid pipeline options";
+  }
+  auto in = File(from, O_RDONLY);
+  struct stat st;
+  if (in.fd < 0 || fstat(in.fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    throw "invalid file";
+  }
+  auto out = File(to, O_WRONLY | O_CREAT | O_TRUNC);
+  if (out.fd < 0) {
+    throw "can't open output file";
+  }
+
+  auto free = Batches(options.batches);
+  auto filled = Batches(options.batches);
+  auto edited = Batches(options.batches);
+  for (size_t i = 0; i < options.batches; ++i) {
+    auto batch = std::string();
+    batch.reserve(options.blockSize);
+    free.push(std::move(batch));
+  }
+
+  auto error = std::exception_ptr();
+  auto errorMutex = std::mutex();
+  auto fail = [&] {
+    {
+      auto lock = std::lock_guard<std::mutex>(errorMutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+    free.close();
+    filled.close();
+    edited.close();
+  };
+
+  auto reader = std::thread([&] {
+    try {
+      readBatches(in.fd, st.st_size, options, free, filled);
+    } catch (...) {
+      fail();
+    }
+    filled.close();
+  });
+  auto writer = std::thread([&] {
+    try {
+      writeBatches(out.fd, options, free, edited);
+    } catch (...) {
+      fail();
+    }
+  });
+  try {
+    auto batch = std::string();
+    while (filled.pop(batch)) {
+      if (!patterns.empty()) {
+        edit(batch, patterns);
+      }
+      edited.push(std::move(batch));
+    }
+  } catch (...) {
+    fail();
+  }
+  edited.close();
+  reader.join();
+  writer.join();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+}
@@ -0,0 +1,39 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <string>
+
+#include "AsyncIo.h"
+#include "PatternSet.h"
+
+namespace nonstd
+{
+struct PipelineOptions
+{
+  static constexpr size_t defaultBlockSize = 1024 * 1024;
+
+  // bytes read per request
+  size_t blockSize = defaultBlockSize;
+  // batches of lines shared by the stages, at least 2
+  size_t batches = 4;
+  IoBackend backend = IoBackend::Auto;
+};
+
+/**
+ * @brief Remove 'patterns' from every line of 'from', writing lines to 'to'
+ *
+ * @details
+ * Reading, editing and writing overlap: a reader thread keeps two block reads
+ * in flight and cuts blocks into batches of whole lines, the calling thread
+ * edits a batch in place and a writer thread appends it to 'to' while the next
+ * one is edited. Batches are recycled through bounded queues, so memory stays
+ * at options.batches blocks whatever the file size. Output is that of
+ * Text::remove() followed by Text::toFile().
+ */
+void filterLines(const std::string& from,
+                 const std::string& to,
+                 const PatternSet& patterns,
+                 const PipelineOptions& options = PipelineOptions());
+}
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+namespace nonstd
+{
+/**
+ * @brief Blocking FIFO holding at most 'capacity' items
+ *
+ * @details
+ * push() waits while the queue is full, pop() while it is empty. After close()
+ * pushes are dropped and pop() returns false once the queue is drained.
+ */
+template<typename T>
+class BoundedQueue
+{
+public:
+  explicit BoundedQueue(size_t capacity) : _capacity(capacity) {}
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue(BoundedQueue&&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(BoundedQueue&&) = delete;
+  ~BoundedQueue() = default;
+
+  void push(T item)
+  {
+    auto lock = std::unique_lock<std::mutex>(_mutex);
+    _notFull.wait(lock,
+                  [this] { return _closed || _items.size() < _capacity; });
+    if (_closed) {
+      return;
+    }
+    _items.push_back(std::move(item));
+    _notEmpty.notify_one();
+  }
+
+  bool pop(T& item)
+  {
+    auto lock = std::unique_lock<std::mutex>(_mutex);
+    _notEmpty.wait(lock, [this] { return _closed || !_items.empty(); });
+    if (_items.empty()) {
+      return false;
+    }
+    item = std::move(_items.front());
+    _items.pop_front();
+    _notFull.notify_one();
+    return true;
+  }
+
+  void close()
+  {
+    auto lock = std::lock_guard<std::mutex>(_mutex);
+    _closed = true;
+    _notEmpty.notify_all();
+    _notFull.notify_all();
+  }
+
+private:
+  size_t _capacity;
+  bool _closed = false;
+  std::deque<T> _items;
+  std::mutex _mutex;
+  std::condition_variable _notEmpty;
+  std::condition_variable _notFull;
+};
+}
+
+#endif
@@ -0,0 +1,117 @@
+#include "Sort.h"
+
+namespace nonstd
+{
+namespace
+{
+struct Task
+{
+  size_t begin;
+  size_t size;
+  size_t depth;
+};
+
+inline unsigned bucket(const RadixItem& item, size_t depth)
+{
+  return depth < item.size ? fold(item.data[depth]) + 1 : 0;
+}
+
+void insertionSort(RadixItem* items, size_t size, size_t depth)
+{
+  for (size_t i = 1; i < size; ++i) {
+    auto item = items[i];
+    auto j = i;
+    for (; j > 0; --j) {
+      const auto& prev = items[j - 1];
+      if (compare(item.data + depth,
+                  item.size - depth,
+                  prev.data + depth,
+                  prev.size - depth) >= 0) {
+        break;
+      }
+      items[j] = prev;
+    }
+    items[j] = item;
+  }
+}
+
+/**
+ * Distribute one task into buckets of its next byte. Sub-tasks of buckets
+ * with more than one line are appended to 'tasks'.
+ */
+void split(std::vector<RadixItem>& items,
+           std::vector<RadixItem>& buffer,
+           Task task,
+           std::vector<Task>& tasks)
+{
+  auto first = items.data() + task.begin;
+  if (task.size < 32) {
+    insertionSort(first, task.size, task.depth);
+    return;
+  }
+
+  size_t count[257];
+  while (true) {
+    std::fill(std::begin(count), std::end(count), 0);
+    for (size_t i = 0; i < task.size; ++i) {
+      ++count[bucket(first[i], task.depth)];
+    }
+    // shared prefix byte, nothing to move
+    auto b = bucket(first[0], task.depth);
+    if (b == 0 || count[b] != task.size) {
+      break;
+    }
+    ++task.depth;
+  }
+  if (count[0] == task.size) {
+    return;
+  }
+
+  size_t position[257];
+  size_t sum = 0;
+  for (size_t b = 0; b < 257; ++b) {
+    position[b] = sum;
+    sum += count[b];
+  }
+  auto out = buffer.data() + task.begin;
+  for (size_t i = 0; i < task.size; ++i) {
+    out[position[bucket(first[i], task.depth)]++] = first[i];
+  }
+  std::copy(out, out + task.size, first);
+
+  // bucket 0 holds lines ending here, they are equal and keep their order
+  auto begin = task.begin + count[0];
+  for (size_t b = 1; b < 257; ++b) {
+    if (count[b] > 1) {
+      tasks.push_back(Task{ begin, count[b], task.depth + 1 });
+    }
+    begin += count[b];
+  }
+}
+
+void run(std::vector<RadixItem>& items,
+         std::vector<RadixItem>& buffer,
+         Task task)
+{
+  auto tasks = std::vector<Task>{ task };
+  while (!tasks.empty()) {
+    auto t = tasks.back();
+    tasks.pop_back();
+    split(items, buffer, t, tasks);
+  }
+}
+}
+
+void radixSort(std::vector<RadixItem>& items, size_t threads)
+{
+  auto buffer = std::vector<RadixItem>(items.size());
+  auto tasks = std::vector<Task>();
+  split(items, buffer, Task{ 0, items.size(), 0 }, tasks);
+  // buckets of the first distinct byte are independent
+  parallelFor(tasks.size(), threads, [&](size_t begin, size_t end) {
+    for (auto i = begin; i < end; ++i) {
+      run(items, buffer, tasks[i]);
+    }
+  });
+}
+}
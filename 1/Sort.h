@@ -0,0 +1,174 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include <algorithm>
+#include <numeric>
+#include <string_view>
+#include <vector>
+
+#include "CaseFold.h"
+#include "Parallel.h"
+
+namespace nonstd
+{
+/**
+ * @brief How lines are sorted, every algorithm gives the same order
+ *
+ * Comparison: stable sort comparing whole lines
+ * PrefixKey: stable sort of case folded 8-byte prefix keys, whole lines are
+ * compared only when the keys are equal
+ * Radix: MSD radix sort on case folded bytes, no whole-line comparisons
+ * except for small buckets
+ */
+enum class SortAlgorithm { Comparison, PrefixKey, Radix };
+
+/**
+ * @brief Line as seen by radixSort()
+ */
+struct RadixItem
+{
+  const char* data;
+  size_t size;
+  size_t index;
+};
+
+/**
+ * @brief Stable MSD radix sort on case folded bytes
+ *
+ * @details
+ * Lines ending at the current depth go first, then 256 buckets of the folded
+ * byte. Buckets of one shared byte are skipped without moving anything and
+ * buckets of less than 32 lines are insertion sorted. Buckets below the first
+ * split are sorted on 'threads' threads.
+ */
+void radixSort(std::vector<RadixItem>& items, size_t threads);
+
+/**
+ * @brief Case-insensitive stable sort of lines
+ *
+ * @tparam T line type
+ * @tparam View callable giving std::string_view of a line
+ */
+template<typename T, typename View>
+void sortLines(std::vector<T>& lines,
+               size_t threads,
+               SortAlgorithm algorithm,
+               View view)
+{
+  if (algorithm == SortAlgorithm::Comparison) {
+    parallelStableSort(lines, threads, [&view](const T& a, const T& b) {
+      auto x = view(a);
+      auto y = view(b);
+      return compare(x.data(), x.size(), y.data(), y.size()) < 0;
+    });
+    return;
+  }
+
+  if (algorithm == SortAlgorithm::Radix) {
+    auto items = std::vector<RadixItem>(lines.size());
+    for (size_t i = 0; i < lines.size(); ++i) {
+      auto l = view(lines[i]);
+      items[i] = RadixItem{ l.data(), l.size(), i };
+    }
+    radixSort(items, threads);
+    auto sorted = std::vector<T>();
+    sorted.reserve(lines.size());
+    for (const auto& item : items) {
+      sorted.push_back(std::move(lines[item.index]));
+    }
+    lines.swap(sorted);
+    return;
+  }
+
+  struct Keyed
+  {
+    uint64_t key;
+    size_t index;
+  };
+  auto keyed = std::vector<Keyed>(lines.size());
+  parallelFor(lines.size(), threads, [&](size_t begin, size_t end) {
+    for (auto i = begin; i < end; ++i) {
+      auto l = view(lines[i]);
+      keyed[i] = Keyed{ prefixKey(l.data(), l.size()), i };
+    }
+  });
+  parallelStableSort(keyed, threads, [&](const Keyed& a, const Keyed& b) {
+    if (a.key != b.key) {
+      return a.key < b.key;
+    }
+    auto x = view(lines[a.index]);
+    auto y = view(lines[b.index]);
+    // equal keys of lines of 8+ bytes mean equal first 8 bytes
+    size_t skip = std::min<size_t>({ x.size(), y.size(), 8 });
+    return compare(x.data() + skip,
+                   x.size() - skip,
+                   y.data() + skip,
+                   y.size() - skip) < 0;
+  });
+  auto sorted = std::vector<T>();
+  sorted.reserve(lines.size());
+  for (const auto& k : keyed) {
+    sorted.push_back(std::move(lines[k.index]));
+  }
+  lines.swap(sorted);
+}
+
+/**
+ * @brief Keep the first 'count' lines of sortLines() order, sorted
+ *
+ * @details
+ * Positions break ties, so the result is the prefix a stable sort gives.
+ * nth_element() finds the count smallest lines in linear time and only they
+ * are sorted.
+ */
+template<typename T, typename View>
+void sortFirstLines(std::vector<T>& lines, size_t count, View view)
+{
+  count = std::min(count, lines.size());
+  auto order = std::vector<size_t>(lines.size());
+  std::iota(order.begin(), order.end(), 0);
+  auto less = [&](size_t a, size_t b) {
+    auto x = view(lines[a]);
+    auto y = view(lines[b]);
+    auto c = compare(x.data(), x.size(), y.data(), y.size());
+    return c < 0 || (c == 0 && a < b);
+  };
+  std::nth_element(order.begin(), order.begin() + count, order.end(), less);
+  std::sort(order.begin(), order.begin() + count, less);
+  auto first = std::vector<T>();
+  first.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    first.push_back(std::move(lines[order[i]]));
+  }
+  lines.swap(first);
+}
+
+/**
+ * @brief Whether 'from' <= line < 'to' ignoring case, empty 'to' has no bound
+ */
+inline bool inRange(std::string_view line,
+                    std::string_view from,
+                    std::string_view to)
+{
+  return compare(line.data(), line.size(), from.data(), from.size()) >= 0 &&
+         (to.empty() ||
+          compare(line.data(), line.size(), to.data(), to.size()) < 0);
+}
+
+/**
+ * @brief Drop lines outside [from, to), the others keep their order
+ */
+template<typename T, typename View>
+void keepRange(std::vector<T>& lines,
+               std::string_view from,
+               std::string_view to,
+               View view)
+{
+  auto end = std::remove_if(lines.begin(), lines.end(), [&](const T& l) {
+    return !inRange(view(l), from, to);
+  });
+  lines.erase(end, lines.end());
+}
+}
+
+#endif
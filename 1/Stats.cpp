@@ -0,0 +1,165 @@
+#include "Stats.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <sys/resource.h>
+#include <time.h>
+
+#ifdef CI_STRING_STATS
+namespace
+{
+std::atomic<uint64_t> allocations{ 0 };
+std::atomic<uint64_t> allocated{ 0 };
+
+void* allocate(size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  allocated.fetch_add(size, std::memory_order_relaxed);
+  while (true) {
+    if (auto* p = malloc(size == 0 ? 1 : size)) {
+      return p;
+    }
+    auto handler = std::get_new_handler();
+    if (!handler) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+}
+}
+
+void* operator new(size_t size)
+{
+  return allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+  return allocate(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+  try {
+    return allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+  try {
+    return allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+  free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+  free(p);
+}
+#endif
+
+namespace nonstd
+{
+namespace
+{
+double cpuSeconds()
+{
+  timespec t;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+}
+
+uint64_t allocationCount()
+{
+#ifdef CI_STRING_STATS
+  return allocations.load(std::memory_order_relaxed);
+#else
+  return 0;
+#endif
+}
+
+uint64_t allocatedBytes()
+{
+#ifdef CI_STRING_STATS
+  return allocated.load(std::memory_order_relaxed);
+#else
+  return 0;
+#endif
+}
+
+uint64_t peakRssBytes()
+{
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  // kilobytes on Linux
+  return uint64_t(usage.ru_maxrss) * 1024;
+}
+
+std::string toJson(const Stats& stats)
+{
+  if (!statsEnabled) {
+    return "{\"enabled\":false}";
+  }
+  auto os = std::ostringstream();
+  os.precision(6);
+  os << std::fixed << "{\"enabled\":true,\"threads\":" << stats.threads
+     << ",\"peak_rss_bytes\":" << stats.peakRssBytes << ",\"stages\":[";
+  for (size_t i = 0; i < stats.stages.size(); ++i) {
+    const auto& s = stats.stages[i];
+    os << (i > 0 ? "," : "") << "{\"name\":\"" << s.name
+       << "\",\"wall_seconds\":" << s.wallSeconds
+       << ",\"cpu_seconds\":" << s.cpuSeconds << ",\"lines_in\":" << s.linesIn
+       << ",\"lines_out\":" << s.linesOut << ",\"bytes_in\":" << s.bytesIn
+       << ",\"bytes_out\":" << s.bytesOut
+       << ",\"pattern_hits\":" << s.patternHits
+       << ",\"allocations\":" << s.allocations
+       << ",\"allocated_bytes\":" << s.allocatedBytes << "}";
+  }
+  os << "]}";
+  return os.str();
+}
+
+StageTimer::StageTimer(Stats& stats, const char* name) :
+  _stats(stats),
+  _wall(std::chrono::steady_clock::now()),
+  _cpu(cpuSeconds()),
+  _allocations(allocationCount()),
+  _allocatedBytes(allocatedBytes())
+{
+  _stage.name = name;
+}
+
+void StageTimer::finish()
+{
+  _stage.wallSeconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - _wall)
+                         .count();
+  _stage.cpuSeconds = cpuSeconds() - _cpu;
+  _stage.allocations = allocationCount() - _allocations;
+  _stage.allocatedBytes = allocatedBytes() - _allocatedBytes;
+  _stats.stages.push_back(_stage);
+  _stats.peakRssBytes = peakRssBytes();
+}
+}
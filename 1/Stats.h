@@ -0,0 +1,92 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nonstd
+{
+/**
+ * @brief Whether the build collects Stats, see the STATS CMake option
+ *
+ * @details
+ * Code filling Stats is guarded by 'if constexpr (statsEnabled)', so without
+ * CI_STRING_STATS it is compiled out, and so is the counting operator new.
+ */
+#ifdef CI_STRING_STATS
+constexpr bool statsEnabled = true;
+#else
+constexpr bool statsEnabled = false;
+#endif
+
+struct StageStats
+{
+  std::string name;
+  double wallSeconds = 0;
+  double cpuSeconds = 0;
+  uint64_t linesIn = 0;
+  uint64_t linesOut = 0;
+  uint64_t bytesIn = 0;
+  uint64_t bytesOut = 0;
+  // lines a remove stage changed
+  uint64_t patternHits = 0;
+  uint64_t allocations = 0;
+  uint64_t allocatedBytes = 0;
+};
+
+struct Stats
+{
+  std::vector<StageStats> stages;
+  size_t threads = 1;
+  uint64_t peakRssBytes = 0;
+};
+
+/**
+ * @brief Stats as one JSON object, {"enabled":false} if not collected
+ */
+std::string toJson(const Stats& stats);
+
+/**
+ * @brief Allocations by operator new since start, 0 without CI_STRING_STATS
+ */
+uint64_t allocationCount();
+uint64_t allocatedBytes();
+
+uint64_t peakRssBytes();
+
+/**
+ * @brief Measures one stage from construction to finish()
+ *
+ * @details
+ * Wall time, process CPU time and allocations between the two are added to
+ * Stats as a new stage, together with what the caller fills in. CPU time and
+ * allocations are process-wide, so they include other threads' work.
+ */
+class StageTimer
+{
+public:
+  StageTimer(Stats& stats, const char* name);
+  StageTimer(const StageTimer&) = delete;
+  StageTimer& operator=(const StageTimer&) = delete;
+  ~StageTimer() = default;
+
+  StageStats& stage()
+  {
+    return _stage;
+  }
+
+  void finish();
+
+private:
+  Stats& _stats;
+  StageStats _stage;
+  std::chrono::steady_clock::time_point _wall;
+  double _cpu;
+  uint64_t _allocations;
+  uint64_t _allocatedBytes;
+};
+}
+
+#endif
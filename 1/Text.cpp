@@ -1,59 +1,493 @@
 #include "Text.h"
+#include "Index.h"
+#include "Newlines.h"
+#include "Pattern.h"
+#include "PatternSet.h"
+#include "Unique.h"
+
+#include <atomic>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace nonstd
 {
 std::basic_ostream<char>& operator<<(
   std::basic_ostream<char>& os,
-  const std::basic_string<char, ci_traits> str)
+  const std::basic_string<char, ci_traits>& str)
 {
-  os << str.c_str();
+  os.write(str.data(), str.size());
   return os;
 }
 
 void remove(nonstd::string& l, const std::string& p)
+{
+  remove(l, Pattern(p));
+}
+
+void remove(nonstd::string& l, const Pattern& p)
+{
+  l.resize(p.removeFrom(&l[0], l.size()));
+}
 
+void remove(nonstd::string& l, const PatternSet& p)
 {
-  std::regex specialChars{ R"([-[\]{}()*+?.,\^$|#\s])" };
-  auto sanitized = std::regex_replace(p, specialChars, R"(\$&)");
-  l = std::regex_replace(l, std::regex(sanitized), "");
+  l.resize(p.removeFrom(&l[0], l.size()));
 }
 
-void sort(Lines& lines)
+void sort(Lines& lines, size_t threads, SortAlgorithm algorithm)
 {
-  std::sort(lines.begin(), lines.end());
+  sortLines(lines, threads, algorithm, [](const nonstd::string& l) {
+    return std::string_view(l.data(), l.size());
+  });
 }
 
+void unique(Lines& lines)
+{
+  uniqueLines(lines, [](const nonstd::string& l) {
+    return std::string_view(l.data(), l.size());
+  });
 }
 
-Text::Text(const std::string& path) : _path(path)
+Lines readLines(const std::string& path, uint64_t begin, uint64_t end)
 {
-  auto file = std::ifstream(path);
-  if (!file.good() || std::experimental::filesystem::is_directory(path)) {
+  auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
     throw "invalid file";
   }
-  std::string tmp;
-  while (std::getline(file, tmp)) {
-    _lines.emplace_back(tmp.c_str());
+  auto data = std::string(end - begin, '\0');
+  uint64_t done = 0;
+  while (done < data.size()) {
+    auto got = pread(fd, &data[done], data.size() - done, begin + done);
+    if (got <= 0) {
+      close(fd);
+      throw "read failed";
+    }
+    done += got;
   }
+  close(fd);
+
+  auto lines = Lines();
+  forEachLine(data.data(), data.size(), [&](size_t begin, size_t end) {
+    lines.emplace_back(data.data() + begin, end - begin);
+  });
+  return lines;
+}
+}
+
+Text::Text(const std::string& path, nonstd::Storage storage, size_t threads) :
+  _storage(storage), _path(path)
+{
+  setThreads(threads);
+  measure("load", [&] {
+    load(path);
+    return size_t(0);
+  });
 }
 
-void Text::remove(const std::string& pattern)
+void Text::load(const std::string& path)
 {
-  for (auto& s : _lines) {
-    nonstd::remove(s, pattern);
+  auto compressed =
+    nonstd::detectCompression(path) != nonstd::Compression::None;
+  // a compressed file can't be mapped, it is decompressed into arenas
+  if (_storage == nonstd::Storage::Mapped && !compressed) {
+    _table.map(path, _threads);
+    return;
+  }
+  if (_storage != nonstd::Storage::Strings) {
+    _table.load(path, nonstd::LineTable::arenaSize, _threads);
+    return;
+  }
+  if (compressed) {
+    loadCompressed(path);
+    return;
+  }
+  auto fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    throw "invalid file";
+  }
+  size_t size = st.st_size;
+  if (size == 0) {
+    close(fd);
+    return;
+  }
+  // the mapping only lives while lines are copied out of it
+  auto map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    throw "can't map file";
+  }
+  madvise(map, size, MADV_SEQUENTIAL);
+  auto data = static_cast<const char*>(map);
+  try {
+    _lines = nonstd::indexLines<nonstd::string>(
+      data, size, _threads, [data](size_t begin, size_t end) {
+        return nonstd::string(data + begin, end - begin);
+      });
+  } catch (...) {
+    munmap(map, size);
+    throw;
+  }
+  munmap(map, size);
+}
+
+void Text::loadCompressed(const std::string& path)
+{
+  auto in = nonstd::Decompressor(path);
+  auto block = std::string(nonstd::Decompressor::blockSize, '\0');
+  size_t filled = 0;
+  while (true) {
+    if (filled == block.size()) {
+      // a line longer than the block
+      block.resize(block.size() * 2);
+    }
+    auto n = in.read(&block[filled], block.size() - filled);
+    if (n == 0) {
+      break;
+    }
+    auto nl = static_cast<const char*>(memrchr(&block[filled], '\n', n));
+    filled += n;
+    if (!nl) {
+      continue;
+    }
+    // lines of this block are copied out while the next one is inflated
+    size_t complete = nl - block.data() + 1;
+    nonstd::forEachLine(block.data(), complete, [&](size_t begin, size_t end) {
+      _lines.emplace_back(block.data() + begin, end - begin);
+    });
+    memmove(&block[0], &block[complete], filled - complete);
+    filled -= complete;
+  }
+  if (filled > 0) {
+    _lines.emplace_back(block.data(), filled);
   }
 }
 
+void Text::remove(const std::string& pattern, bool ignoreCase)
+{
+  remove(std::vector<std::string>{ pattern }, ignoreCase);
+}
+
+void Text::remove(const std::vector<std::string>& patterns, bool ignoreCase)
+{
+  auto nonEmpty = std::vector<std::string>();
+  std::copy_if(patterns.begin(),
+               patterns.end(),
+               std::back_inserter(nonEmpty),
+               [](const std::string& p) { return !p.empty(); });
+  if (nonEmpty.empty()) {
+    return;
+  }
+  if (_pending.empty() || _pending.back().kind != Operation::Kind::Remove ||
+      _pending.back().ignoreCase != ignoreCase) {
+    _pending.push_back(
+      Operation{ Operation::Kind::Remove, {}, 0, ignoreCase });
+  }
+  auto& last = _pending.back().patterns;
+  last.insert(last.end(), nonEmpty.begin(), nonEmpty.end());
+}
+
 void Text::sort()
 {
-  nonstd::sort(_lines);
+  if (_pending.empty() || _pending.back().kind != Operation::Kind::Sort) {
+    _pending.push_back(Operation{ Operation::Kind::Sort, {} });
+  }
+}
+
+void Text::sortFirst(size_t count)
+{
+  _pending.push_back(Operation{ Operation::Kind::SortFirst, {}, count });
+}
+
+void Text::sortRange(const std::string& from, const std::string& to)
+{
+  _pending.push_back(Operation{ Operation::Kind::SortRange, { from, to } });
+}
+
+void Text::unique()
+{
+  auto at = _pending.end();
+  // stable sort keeps the first of equal lines first, so order doesn't matter
+  if (at != _pending.begin() && (at - 1)->kind == Operation::Kind::Sort) {
+    --at;
+  }
+  if (at != _pending.begin() && (at - 1)->kind == Operation::Kind::Unique) {
+    return;
+  }
+  _pending.insert(at, Operation{ Operation::Kind::Unique, {} });
+}
+
+void Text::run(nonstd::Writer* out)
+{
+  auto pending = std::move(_pending);
+  _pending.clear();
+  for (size_t i = 0; i < pending.size(); ++i) {
+    const auto& op = pending[i];
+    if (op.kind == Operation::Kind::Sort) {
+      measure("sort", [this] {
+        sortNow();
+        return size_t(0);
+      });
+    } else if (op.kind == Operation::Kind::SortFirst) {
+      measure("sort-first", [&] {
+        sortFirstNow(op.count);
+        return size_t(0);
+      });
+    } else if (op.kind == Operation::Kind::SortRange) {
+      measure("sort-range", [&] {
+        keepRangeNow(op.patterns[0], op.patterns[1]);
+        sortNow();
+        return size_t(0);
+      });
+    } else if (op.kind == Operation::Kind::Unique) {
+      measure("unique", [this] {
+        uniqueNow();
+        return size_t(0);
+      });
+    } else if (i + 1 < pending.size() || _threads > 1 || !out) {
+      measure("remove", [&] {
+        if (op.patterns.size() == 1) {
+          return removeNow(nonstd::Pattern(op.patterns[0], op.ignoreCase));
+        }
+        return removeNow(nonstd::PatternSet(op.patterns, op.ignoreCase));
+      });
+    } else {
+      measure("remove+write", [&] {
+        if (op.patterns.size() == 1) {
+          auto pattern = nonstd::Pattern(op.patterns[0], op.ignoreCase);
+          return removeAndWrite(pattern, *out);
+        }
+        auto set = nonstd::PatternSet(op.patterns, op.ignoreCase);
+        return removeAndWrite(set, *out);
+      });
+      return;
+    }
+  }
+  if (out) {
+    measure("write", [&] {
+      write(*out);
+      return size_t(0);
+    });
+  }
+}
+
+template<typename F>
+void Text::measure(const char* name, F f)
+{
+  if constexpr (!nonstd::statsEnabled) {
+    f();
+  } else {
+    auto timer = nonstd::StageTimer(_stats, name);
+    auto& stage = timer.stage();
+    stage.linesIn = lineCount();
+    stage.bytesIn = byteCount();
+    stage.patternHits = f();
+    stage.linesOut = lineCount();
+    stage.bytesOut = byteCount();
+    timer.finish();
+  }
+}
+
+template<typename Matcher>
+size_t Text::removeNow(const Matcher& m)
+{
+  if (_storage != nonstd::Storage::Strings) {
+    return _table.remove(m, _threads);
+  }
+  auto changed = std::atomic<size_t>(0);
+  nonstd::parallelFor(_lines.size(), _threads, [&](size_t begin, size_t end) {
+    size_t count = 0;
+    for (auto i = begin; i < end; ++i) {
+      auto size = _lines[i].size();
+      nonstd::remove(_lines[i], m);
+      count += _lines[i].size() != size;
+    }
+    changed += count;
+  });
+  return changed;
+}
+
+template<typename Matcher>
+size_t Text::removeAndWrite(const Matcher& m, nonstd::Writer& out)
+{
+  if (_storage != nonstd::Storage::Strings) {
+    return _table.removeAndWrite(m, out);
+  }
+  size_t changed = 0;
+  for (auto& l : _lines) {
+    auto size = l.size();
+    nonstd::remove(l, m);
+    changed += l.size() != size;
+    out.line(std::string_view(l.data(), l.size()));
+  }
+  return changed;
+}
+
+void Text::sortNow()
+{
+  if (_storage != nonstd::Storage::Strings) {
+    _table.sort(_threads, _sortAlgorithm);
+    return;
+  }
+  nonstd::sort(_lines, _threads, _sortAlgorithm);
+}
+
+void Text::sortFirstNow(size_t count)
+{
+  if (_storage != nonstd::Storage::Strings) {
+    _table.sortFirst(count);
+    return;
+  }
+  nonstd::sortFirstLines(_lines, count, [](const nonstd::string& l) {
+    return std::string_view(l.data(), l.size());
+  });
+}
+
+void Text::keepRangeNow(const std::string& from, const std::string& to)
+{
+  if (_storage != nonstd::Storage::Strings) {
+    _table.keepRange(from, to);
+    return;
+  }
+  nonstd::keepRange(_lines, from, to, [](const nonstd::string& l) {
+    return std::string_view(l.data(), l.size());
+  });
+}
+
+void Text::uniqueNow()
+{
+  if (_storage != nonstd::Storage::Strings) {
+    _table.unique();
+    return;
+  }
+  nonstd::unique(_lines);
+}
+
+void Text::write(nonstd::Writer& out) const
+{
+  if (_storage != nonstd::Storage::Strings) {
+    _table.write(out);
+    return;
+  }
+  for (const auto& l : _lines) {
+    out.line(std::string_view(l.data(), l.size()));
+  }
+}
+
+void Text::writeParallel(const std::string& path,
+                         size_t bufferSize,
+                         bool sync) const
+{
+  if (_storage != nonstd::Storage::Strings) {
+    nonstd::writeParallel(
+      path,
+      _table.size(),
+      [this](size_t i) { return _table.line(i); },
+      _threads,
+      sync,
+      bufferSize);
+    return;
+  }
+  nonstd::writeParallel(
+    path,
+    _lines.size(),
+    [this](size_t i) {
+      return std::string_view(_lines[i].data(), _lines[i].size());
+    },
+    _threads,
+    sync,
+    bufferSize);
+}
+
+size_t Text::lineCount() const
+{
+  if (_storage != nonstd::Storage::Strings) {
+    return _table.size();
+  }
+  return _lines.size();
+}
+
+size_t Text::byteCount() const
+{
+  size_t bytes = lineCount();
+  if (_storage != nonstd::Storage::Strings) {
+    for (size_t i = 0; i < _table.size(); ++i) {
+      bytes += _table.line(i).size();
+    }
+    return bytes;
+  }
+  for (const auto& l : _lines) {
+    bytes += l.size();
+  }
+  return bytes;
+}
+
+void Text::setThreads(size_t count)
+{
+  _threads = count;
+  if (_threads == 0) {
+    _threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  _stats.threads = _threads;
+}
+
+void Text::setSortAlgorithm(nonstd::SortAlgorithm algorithm)
+{
+  _sortAlgorithm = algorithm;
+}
+
+void Text::setOutputCompression(nonstd::Compression compression)
+{
+  _outputCompression = compression;
+}
+
+void Text::setIndexed(bool indexed, size_t sparseStep)
+{
+  _indexed = indexed;
+  _sparseStep = sparseStep;
 }
 
 void Text::toFile()
 {
-  auto outFile = std::ofstream(_path + "_processed");
-  std::copy(_lines.begin(),
-            _lines.end(),
-            std::ostream_iterator<nonstd::string>(outFile, "\n"));
+  toFile(_path + "_processed");
 }
 
+void Text::toFile(const std::string& path, size_t bufferSize, bool sync)
+{
+  if (_indexed && _outputCompression != nonstd::Compression::None) {
+    throw "can't index compressed output";
+  }
+  if (!nonstd::AtomicFile::replaceable(path)) {
+    auto out =
+      nonstd::Writer(path, bufferSize, sync, false, _outputCompression);
+    run(&out);
+    out.close();
+  } else if (_threads > 1 && _outputCompression == nonstd::Compression::None) {
+    run(nullptr);
+    measure("write", [&] {
+      writeParallel(path, bufferSize, sync);
+      return size_t(0);
+    });
+  } else {
+    auto file = nonstd::AtomicFile(path);
+    {
+      auto out = nonstd::Writer(
+        file.temporary(), bufferSize, sync, false, _outputCompression);
+      run(&out);
+      out.close();
+    }
+    file.commit(false);
+  }
+  if (_indexed) {
+    measure("index", [&] {
+      nonstd::buildIndex(path, _sparseStep);
+      return size_t(0);
+    });
+  }
+}
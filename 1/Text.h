@@ -1,13 +1,19 @@
 #ifndef TEXT_H
 #define TEXT_H
 
+#include <algorithm>
 #include <experimental/filesystem>
 #include <fstream>
 #include <iostream>
-#include <regex>
-#include <string.h>
+#include <iterator>
 #include <vector>
 
+#include "CaseFold.h"
+#include "LineTable.h"
+#include "Sort.h"
+#include "Stats.h"
+#include "Writer.h"
+
 using namespace std::string_literals;
 
 namespace nonstd
@@ -16,36 +22,216 @@ struct ci_traits : public std::char_traits<char>
 {
   static int compare(const char* c1, const char* c2, size_t n)
   {
-    return strcasecmp(c1, c2);
+    return nonstd::compare(c1, c2, n);
   }
 };
 std::basic_ostream<char>& operator<<(
   std::basic_ostream<char>& os,
-  const std::basic_string<char, ci_traits> str);
+  const std::basic_string<char, ci_traits>& str);
 
 using string = std::basic_string<char, ci_traits>;
 using Lines = std::vector<string>;
+
+/**
+ * @brief How Text keeps its lines
+ *
+ * Strings: every line is a nonstd::string
+ * Mapped: file is memory mapped, lines are copied only when changed
+ * Arena: file is read into a few large arenas, lines are handles into them
+ */
+enum class Storage { Strings, Mapped, Arena };
+class Pattern;
+class PatternSet;
 void remove(nonstd::string& l, const std::string& p);
-void sort(Lines& lines);
+void remove(nonstd::string& l, const Pattern& p);
+void remove(nonstd::string& l, const PatternSet& p);
+void sort(Lines& lines,
+          size_t threads = 1,
+          SortAlgorithm algorithm = SortAlgorithm::Comparison);
+void unique(Lines& lines);
+
+/**
+ * @brief Lines of bytes [begin, end) of a file, 'begin' at a line start
+ */
+Lines readLines(const std::string& path, uint64_t begin, uint64_t end);
 }
 
+/**
+ * @brief Lines of a file processed case-insensitively
+ *
+ * @details
+ * remove(), sort() and its variants and unique() only record the operation,
+ * toFile() runs them. Consecutive removes alike in ignoring case become one
+ * pattern set applied in a single scan, a repeated sort() or unique() is
+ * dropped and unique() right after sort() runs before it, on fewer lines, with
+ * the same result. When the last operation is a remove on one thread, every
+ * line is edited and written in the same pass.
+ *
+ * Built with CI_STRING_STATS, every stage from loading to writing is measured
+ * into stats(), otherwise the measuring code is compiled out.
+ */
 class Text
 {
 public:
-  explicit Text(const std::string& path);
+  /**
+   * @brief Load lines of 'path'
+   *
+   * @details
+   * Lines are indexed with a vectorized newline search, a big file on several
+   * threads. They are the lines std::getline() gives, NUL bytes included.
+   * Gzip (or zstd) input is recognized by its magic bytes and decompressed
+   * on another thread while lines are loaded, Mapped storage then loads it
+   * into arenas.
+   *
+   * @param threads threads to load and process on, see setThreads()
+   */
+  explicit Text(const std::string& path,
+                nonstd::Storage storage = nonstd::Storage::Strings,
+                size_t threads = 1);
   Text(const Text&) = delete;
   Text(Text&&) = delete;
   Text& operator=(const Text&) = delete;
   Text& operator=(Text&&) = delete;
   ~Text() = default;
 
-  void remove(const std::string& pattern);
+  /**
+   * @brief Remove pattern from every line
+   *
+   * @param ignoreCase remove every ASCII case variant of it in the same pass
+   */
+  void remove(const std::string& pattern, bool ignoreCase = false);
+  void remove(const std::vector<std::string>& patterns,
+              bool ignoreCase = false);
   void sort();
+
+  /**
+   * @brief Sort and keep only the first 'count' lines
+   *
+   * @details
+   * Gives the first 'count' lines of sort() without sorting the others.
+   */
+  void sortFirst(size_t count);
+
+  /**
+   * @brief Sort and keep only lines from 'from' up to but excluding 'to'
+   *
+   * @details
+   * Bounds compare ignoring case like sort() does, an empty 'to' keeps every
+   * line from 'from' on. Lines out of range are dropped before sorting.
+   */
+  void sortRange(const std::string& from, const std::string& to = "");
+
+  /**
+   * @brief Drop lines equal to an earlier one ignoring case
+   *
+   * @details
+   * The first occurrence is kept and lines keep their order, so it gives the
+   * same output before or after sort().
+   */
+  void unique();
   void toFile();
 
+  /**
+   * @brief Write lines to 'path'
+   *
+   * @details
+   * A regular output file is written next to 'path' and renamed over it, so
+   * it never shows partly written. With several threads and no compression
+   * the threads write disjoint parts of it in parallel.
+   *
+   * @param path output file
+   * @param bufferSize bytes batched per write() call
+   * @param sync fsync() the output before returning
+   */
+  void toFile(const std::string& path,
+              size_t bufferSize = nonstd::Writer::defaultBufferSize,
+              bool sync = false);
+
+  /**
+   * @brief Set number of threads remove(), sort() and toFile() run on
+   *
+   * @details
+   * Output doesn't depend on it: every thread gets a contiguous range of
+   * lines and sorting stays stable.
+   *
+   * @param count number of threads, 0 means one per hardware thread
+   */
+  void setThreads(size_t count);
+
+  void setSortAlgorithm(nonstd::SortAlgorithm algorithm);
+
+  /**
+   * @brief Compress what toFile() writes, uncompressed by default
+   */
+  void setOutputCompression(nonstd::Compression compression);
+
+  /**
+   * @brief Write a SortedIndex of the output next to it after toFile()
+   *
+   * @details
+   * The output must be sorted and uncompressed, see nonstd::buildIndex().
+   *
+   * @param sparseStep lines per prefix table entry, 0 writes no table
+   */
+  void setIndexed(bool indexed, size_t sparseStep = 64);
+
+  /**
+   * @brief Stages run so far, empty without CI_STRING_STATS
+   *
+   * @details
+   * Lines and bytes of a stage are those Text holds before and after it,
+   * newlines included, pattern hits are the lines a remove changed.
+   */
+  const nonstd::Stats& stats() const
+  {
+    return _stats;
+  }
+
 private:
+  struct Operation
+  {
+    enum class Kind { Remove, Sort, SortFirst, SortRange, Unique };
+
+    Kind kind;
+    // patterns to remove or the bounds of SortRange
+    std::vector<std::string> patterns;
+    // lines SortFirst keeps
+    size_t count = 0;
+    bool ignoreCase = false;
+  };
+
+  void load(const std::string& path);
+  void loadCompressed(const std::string& path);
+  // without 'out' pending operations run but nothing is written
+  void run(nonstd::Writer* out);
+  template<typename F>
+  void measure(const char* name, F f);
+  template<typename Matcher>
+  size_t removeNow(const Matcher& m);
+  template<typename Matcher>
+  size_t removeAndWrite(const Matcher& m, nonstd::Writer& out);
+  void sortNow();
+  void sortFirstNow(size_t count);
+  void keepRangeNow(const std::string& from, const std::string& to);
+  void uniqueNow();
+  void write(nonstd::Writer& out) const;
+  void writeParallel(const std::string& path,
+                     size_t bufferSize,
+                     bool sync) const;
+  size_t lineCount() const;
+  size_t byteCount() const;
+
+  nonstd::Storage _storage;
+  size_t _threads = 1;
+  nonstd::SortAlgorithm _sortAlgorithm = nonstd::SortAlgorithm::Comparison;
+  std::vector<Operation> _pending;
+  nonstd::Compression _outputCompression = nonstd::Compression::None;
+  bool _indexed = false;
+  size_t _sparseStep = 0;
   nonstd::Lines _lines;
+  nonstd::LineTable _table;
   std::string _path;
+  nonstd::Stats _stats;
 };
 
 #endif
@@ -0,0 +1,453 @@
+#include "TextStream.h"
+#include "Merge.h"
+#include "Pipeline.h"
+#include "Unique.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <memory>
+#include <set>
+#include <system_error>
+#include <stdlib.h>
+#include <unistd.h>
+
+namespace
+{
+// partitions are split again at most this many times
+constexpr uint64_t maxPartitionDepth = 4;
+
+void write(nonstd::Writer& out, const nonstd::string& line)
+{
+  out.line(std::string_view(line.data(), line.size()));
+}
+
+// the old output stays until 'write' made the whole new one
+template<typename Write>
+void replace(const std::string& path, Write write)
+{
+  if (!nonstd::AtomicFile::replaceable(path)) {
+    write(path);
+    return;
+  }
+  auto file = nonstd::AtomicFile(path);
+  write(file.temporary());
+  file.commit(false);
+}
+}
+
+/**
+ * @brief Files spilled by one toFile() call, removed with it however it ends
+ *
+ * @details
+ * Names start with one reserved next to the output, so other calls don't use
+ * them.
+ */
+struct TextStream::Scratch
+{
+  explicit Scratch(const std::string& output) : reserved(output + "_tmpXXXXXX")
+  {
+    auto fd = mkostemp(&reserved[0], O_CLOEXEC);
+    if (fd < 0) {
+      throw "can't open output file";
+    }
+    close(fd);
+  }
+  Scratch(const Scratch&) = delete;
+  Scratch& operator=(const Scratch&) = delete;
+  ~Scratch()
+  {
+    auto error = std::error_code();
+    for (const auto& f : files) {
+      std::experimental::filesystem::remove(f, error);
+    }
+    std::experimental::filesystem::remove(reserved, error);
+  }
+
+  std::string next(const char* kind)
+  {
+    files.push_back(reserved + kind + std::to_string(files.size()));
+    return files.back();
+  }
+
+  std::string reserved;
+  std::vector<std::string> files;
+};
+
+TextStream::TextStream(const std::string& path, size_t memoryLimit) :
+  _memoryLimit(memoryLimit), _path(path)
+{
+  auto file = std::ifstream(path);
+  if (!file.good() || std::experimental::filesystem::is_directory(path)) {
+    throw "invalid file";
+  }
+  if (memoryLimit == 0) {
+    throw "invalid memory limit";
+  }
+}
+
+void TextStream::remove(const std::string& pattern)
+{
+  _patterns.push_back(pattern);
+}
+
+void TextStream::remove(const std::vector<std::string>& patterns)
+{
+  _patterns.insert(_patterns.end(), patterns.begin(), patterns.end());
+}
+
+void TextStream::sort()
+{
+  _sort = true;
+}
+
+void TextStream::sortFirst(size_t count)
+{
+  _sort = true;
+  _first = count;
+}
+
+void TextStream::sortRange(const std::string& from, const std::string& to)
+{
+  _sort = true;
+  _range = true;
+  _from = from;
+  _to = to;
+}
+
+void TextStream::unique()
+{
+  _unique = true;
+}
+
+void TextStream::setIoBackend(nonstd::IoBackend backend)
+{
+  _ioBackend = backend;
+}
+
+void TextStream::toFile()
+{
+  toFile(_path + "_processed");
+}
+
+void TextStream::toFile(const std::string& path)
+{
+  if (!_sort && !_unique) {
+    auto options = nonstd::PipelineOptions();
+    // blocks of every batch and the two being read stay below the limit
+    options.blockSize = std::clamp<size_t>(
+      _memoryLimit / (options.batches + 2), 1, options.blockSize);
+    options.backend = _ioBackend;
+    replace(path, [&](const std::string& to) {
+      nonstd::filterLines(_path, to, nonstd::PatternSet(_patterns), options);
+    });
+    return;
+  }
+  auto in = std::ifstream(_path);
+  auto patterns = nonstd::PatternSet(_patterns);
+  auto scratch = Scratch(path);
+  _scratch = &scratch;
+  replace(path, [&](const std::string& to) {
+    auto out = nonstd::Writer(to);
+    run(in, out, patterns);
+    out.close();
+  });
+  _scratch = nullptr;
+}
+
+void TextStream::run(std::ifstream& in,
+                     nonstd::Writer& out,
+                     const nonstd::PatternSet& patterns)
+{
+  if (_first != all) {
+    keepFirst(in, out, patterns);
+    return;
+  }
+  auto chunk = nonstd::Lines();
+  auto runs = std::vector<std::string>();
+  auto more = true;
+  while (more) {
+    more = readChunk(in, chunk);
+    if (_unique && !_sort && more) {
+      // does not fit in memory, duplicates may be chunks apart
+      runs = partition(in, chunk, patterns);
+      uniquePartitions(runs, out);
+      return;
+    }
+    process(chunk, patterns);
+    if (!_sort || (!more && runs.empty())) {
+      for (const auto& l : chunk) {
+        write(out, l);
+      }
+    } else {
+      runs.push_back(spill(chunk));
+    }
+    chunk.clear();
+  }
+  if (!runs.empty()) {
+    merge(runs, out, _unique);
+  }
+}
+
+bool TextStream::readChunk(std::ifstream& in, nonstd::Lines& chunk)
+{
+  size_t used = 0;
+  std::string tmp;
+  while (used < _memoryLimit && std::getline(in, tmp)) {
+    chunk.emplace_back(tmp.data(), tmp.size());
+    used += chunk.back().size() + sizeof(nonstd::string);
+  }
+  return in.peek() != std::ifstream::traits_type::eof();
+}
+
+void TextStream::process(nonstd::Lines& chunk,
+                         const nonstd::PatternSet& patterns)
+{
+  if (!patterns.empty()) {
+    for (auto& l : chunk) {
+      nonstd::remove(l, patterns);
+    }
+  }
+  if (_range) {
+    nonstd::keepRange(chunk, _from, _to, [](const nonstd::string& l) {
+      return std::string_view(l.data(), l.size());
+    });
+  }
+  if (_unique) {
+    nonstd::unique(chunk);
+  }
+  if (_sort) {
+    nonstd::sort(chunk);
+  }
+}
+
+std::vector<std::string> TextStream::partition(
+  std::ifstream& in,
+  nonstd::Lines& chunk,
+  const nonstd::PatternSet& patterns)
+{
+  auto count = partCount(std::experimental::filesystem::file_size(_path));
+  auto names = std::vector<std::string>();
+  auto files = std::vector<std::unique_ptr<nonstd::Writer>>();
+  for (size_t i = 0; i < count; ++i) {
+    names.push_back(scratch("_part"));
+    files.push_back(std::make_unique<nonstd::Writer>(names.back(), 64 * 1024));
+  }
+
+  size_t seq = 0;
+  char key[sequenceDigits + 1];
+  auto line = std::string();
+  auto more = true;
+  while (true) {
+    if (!patterns.empty()) {
+      for (auto& l : chunk) {
+        nonstd::remove(l, patterns);
+      }
+    }
+    for (const auto& l : chunk) {
+      // input position as fixed width hex sorts the same ignoring case
+      snprintf(key, sizeof(key), "%016zx", seq++);
+      line.assign(key, sequenceDigits);
+      line.append(l.data(), l.size());
+      auto p = nonstd::foldedHash(l.data(), l.size()) % count;
+      files[p]->line(line);
+    }
+    chunk.clear();
+    if (!more) {
+      break;
+    }
+    more = readChunk(in, chunk);
+  }
+  for (auto& f : files) {
+    f->close();
+  }
+  return names;
+}
+
+std::vector<std::string> TextStream::repartition(const std::string& name,
+                                                 uint64_t seed)
+{
+  namespace fs = std::experimental::filesystem;
+  auto count = partCount(fs::file_size(name));
+  auto names = std::vector<std::string>();
+  auto files = std::vector<std::unique_ptr<nonstd::Writer>>();
+  for (size_t i = 0; i < count; ++i) {
+    names.push_back(scratch("_part"));
+    files.push_back(std::make_unique<nonstd::Writer>(names.back(), 64 * 1024));
+  }
+  {
+    auto in = std::ifstream(name);
+    auto line = std::string();
+    while (std::getline(in, line)) {
+      auto l = std::string_view(line).substr(sequenceDigits);
+      files[nonstd::foldedHash(l.data(), l.size(), seed) % count]->line(line);
+    }
+  }
+  for (auto& f : files) {
+    f->close();
+  }
+  auto used = std::count_if(names.begin(), names.end(), [](const auto& n) {
+    return fs::file_size(n) > 0;
+  });
+  if (used > 1) {
+    return names;
+  }
+  // equal lines only, they can't be split
+  for (const auto& n : names) {
+    fs::remove(n);
+  }
+  return {};
+}
+
+size_t TextStream::partCount(uintmax_t size) const
+{
+  return std::min<size_t>(maxMergeFanIn, size * 2 / _memoryLimit + 1);
+}
+
+void TextStream::keepFirst(std::ifstream& in,
+                           nonstd::Writer& out,
+                           const nonstd::PatternSet& patterns)
+{
+  struct Entry
+  {
+    nonstd::string line;
+    size_t seq;
+  };
+  // input position keeps the sort stable and the first of equal lines
+  auto less = [](const Entry& a, const Entry& b) {
+    auto c = nonstd::compare(
+      a.line.data(), a.line.size(), b.line.data(), b.line.size());
+    return c < 0 || (c == 0 && a.seq < b.seq);
+  };
+  auto first = std::set<Entry, decltype(less)>(less);
+  if (_first == 0) {
+    return;
+  }
+  size_t seq = 0;
+  auto line = std::string();
+  while (std::getline(in, line)) {
+    ++seq;
+    if (!patterns.empty()) {
+      line.resize(patterns.removeFrom(&line[0], line.size()));
+    }
+    if (_range && !nonstd::inRange(line, _from, _to)) {
+      continue;
+    }
+    if (first.size() == _first) {
+      // later lines lose ties, so only smaller ones get in
+      const auto& last = first.rbegin()->line;
+      if (nonstd::compare(
+            line.data(), line.size(), last.data(), last.size()) >= 0) {
+        continue;
+      }
+    }
+    auto entry = Entry{ nonstd::string(line.data(), line.size()), seq };
+    auto at = first.lower_bound(entry);
+    if (_unique && at != first.begin()) {
+      const auto& before = std::prev(at)->line;
+      if (before == entry.line) {
+        continue;
+      }
+    }
+    first.insert(at, std::move(entry));
+    if (first.size() > _first) {
+      first.erase(std::prev(first.end()));
+    }
+  }
+  for (const auto& e : first) {
+    write(out, e.line);
+  }
+}
+
+void TextStream::uniquePartitions(const std::vector<std::string>& parts,
+                                  nonstd::Writer& out)
+{
+  auto done = std::vector<std::string>();
+  for (const auto& name : parts) {
+    uniquePart(name, 1, done);
+  }
+  // positions are unique, so parts merge back in input order
+  merge(done, out, false, sequenceDigits);
+}
+
+void TextStream::uniquePart(const std::string& name,
+                            uint64_t seed,
+                            std::vector<std::string>& done)
+{
+  if (std::experimental::filesystem::file_size(name) > _memoryLimit &&
+      seed <= maxPartitionDepth) {
+    auto parts = repartition(name, seed);
+    if (!parts.empty()) {
+      std::experimental::filesystem::remove(name);
+      for (const auto& p : parts) {
+        uniquePart(p, seed + 1, done);
+      }
+      return;
+    }
+  }
+  auto view = [](const nonstd::string& l) {
+    return std::string_view(l.data(), l.size()).substr(sequenceDigits);
+  };
+  auto lines = nonstd::Lines();
+  {
+    auto in = std::ifstream(name);
+    std::string tmp;
+    while (std::getline(in, tmp)) {
+      lines.emplace_back(tmp.data(), tmp.size());
+    }
+  }
+  nonstd::uniqueLines(lines, view);
+  spill(lines, name);
+  done.push_back(name);
+}
+
+std::string TextStream::scratch(const char* kind)
+{
+  return _scratch->next(kind);
+}
+
+std::string TextStream::spill(const nonstd::Lines& chunk)
+{
+  auto name = scratch("_run");
+  spill(chunk, name);
+  return name;
+}
+
+void TextStream::spill(const nonstd::Lines& chunk, const std::string& name)
+{
+  auto file = nonstd::Writer(name);
+  for (const auto& l : chunk) {
+    write(file, l);
+  }
+  file.close();
+}
+
+void TextStream::merge(const std::vector<std::string>& runs,
+                       nonstd::Writer& out,
+                       bool unique,
+                       size_t skip)
+{
+  auto pending = runs;
+  // merging consecutive groups keeps equal lines in input order
+  while (pending.size() > maxMergeFanIn) {
+    auto merged = std::vector<std::string>();
+    for (size_t i = 0; i < pending.size(); i += maxMergeFanIn) {
+      auto last = std::min(i + maxMergeFanIn, pending.size());
+      auto group = std::vector<std::string>(pending.begin() + i,
+                                            pending.begin() + last);
+      auto name = scratch("_run");
+      auto file = nonstd::Writer(name);
+      nonstd::mergeRuns(group, file, unique);
+      file.close();
+      for (const auto& r : group) {
+        std::experimental::filesystem::remove(r);
+      }
+      merged.push_back(name);
+    }
+    pending = merged;
+  }
+  nonstd::mergeRuns(pending, out, unique, skip);
+  for (const auto& r : pending) {
+    std::experimental::filesystem::remove(r);
+  }
+}
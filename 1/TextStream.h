@@ -0,0 +1,114 @@
+#ifndef TEXT_STREAM_H
+#define TEXT_STREAM_H
+
+#include <limits>
+
+#include "AsyncIo.h"
+#include "PatternSet.h"
+#include "Text.h"
+
+/**
+ * @brief Bounded-memory counterpart of Text
+ *
+ * @details
+ * Operations are recorded and run by toFile() chunk by chunk: at most
+ * memoryLimit bytes of lines are held at once. With only remove() the file
+ * goes through filterLines(), which overlaps reading, editing and writing.
+ * With sort() every chunk becomes a sorted run spilled next to the output file
+ * and the runs are k-way merged, so the output is byte-identical to Text's.
+ * Spilled files are named after the output with a suffix unique to the call
+ * and removed however it ends. The output is replaced once it is complete.
+ *
+ * unique() without sort() on input larger than the limit hash-partitions the
+ * lines, tagged with their position, into files small enough to dedupe in
+ * memory and merges the partitions back into input order. At most
+ * maxMergeFanIn parts are written at once, parts still above the limit are
+ * partitioned again with another hash.
+ *
+ * sortFirst() reads line by line and holds only the first 'count' lines seen
+ * so far, so any file fits in memory.
+ */
+class TextStream
+{
+public:
+  static constexpr size_t defaultMemoryLimit = 64 * 1024 * 1024;
+  static constexpr size_t maxMergeFanIn = 64;
+  static constexpr size_t sequenceDigits = 16;
+  static constexpr size_t all = std::numeric_limits<size_t>::max();
+
+  explicit TextStream(const std::string& path,
+                      size_t memoryLimit = defaultMemoryLimit);
+  TextStream(const TextStream&) = delete;
+  TextStream(TextStream&&) = delete;
+  TextStream& operator=(const TextStream&) = delete;
+  TextStream& operator=(TextStream&&) = delete;
+  ~TextStream() = default;
+
+  void remove(const std::string& pattern);
+  void remove(const std::vector<std::string>& patterns);
+  void sort();
+
+  /**
+   * @brief Sort and keep only the first 'count' lines, see Text::sortFirst()
+   */
+  void sortFirst(size_t count);
+
+  /**
+   * @brief Sort and keep only lines in [from, to), see Text::sortRange()
+   */
+  void sortRange(const std::string& from, const std::string& to = "");
+  void unique();
+  void toFile();
+  void toFile(const std::string& path);
+
+  /**
+   * @brief Set how the remove-only pipeline reads and writes
+   */
+  void setIoBackend(nonstd::IoBackend backend);
+
+private:
+  struct Scratch;
+
+  void run(std::ifstream& in,
+           nonstd::Writer& out,
+           const nonstd::PatternSet& patterns);
+  bool readChunk(std::ifstream& in, nonstd::Lines& chunk);
+  void process(nonstd::Lines& chunk, const nonstd::PatternSet& patterns);
+  std::vector<std::string> partition(std::ifstream& in,
+                                     nonstd::Lines& chunk,
+                                     const nonstd::PatternSet& patterns);
+  std::vector<std::string> repartition(const std::string& name,
+                                       uint64_t seed);
+  size_t partCount(uintmax_t size) const;
+  void keepFirst(std::ifstream& in,
+                 nonstd::Writer& out,
+                 const nonstd::PatternSet& patterns);
+  void uniquePartitions(const std::vector<std::string>& parts,
+                        nonstd::Writer& out);
+  void uniquePart(const std::string& name,
+                  uint64_t seed,
+                  std::vector<std::string>& done);
+  std::string scratch(const char* kind);
+  std::string spill(const nonstd::Lines& chunk);
+  void spill(const nonstd::Lines& chunk, const std::string& name);
+  void merge(const std::vector<std::string>& runs,
+             nonstd::Writer& out,
+             bool unique,
+             size_t skip = 0);
+
+  std::vector<std::string> _patterns;
+  bool _sort = false;
+  bool _unique = false;
+  // lines sortFirst() keeps
+  size_t _first = all;
+  bool _range = false;
+  std::string _from;
+  std::string _to;
+  nonstd::IoBackend _ioBackend = nonstd::IoBackend::Auto;
+  size_t _memoryLimit;
+  std::string _path;
+  // names files spilled by the running toFile()
+  Scratch* _scratch = nullptr;
+};
+
+#endif
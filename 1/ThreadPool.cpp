@@ -0,0 +1,128 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace nonstd
+{
+namespace
+{
+// pool and index of the worker running on this thread
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local size_t currentWorker = 0;
+}
+
+ThreadPool::ThreadPool(size_t threads)
+{
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    _queues.push_back(std::make_unique<Queue>());
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    _workers.emplace_back([this, i] { loop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    auto lock = std::lock_guard<std::mutex>(_mutex);
+    _stop = true;
+  }
+  _wake.notify_all();
+  for (auto& w : _workers) {
+    w.join();
+  }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+  {
+    // counted before it's visible, so it can't finish before being counted
+    auto lock = std::lock_guard<std::mutex>(_mutex);
+    ++_queued;
+    ++_pending;
+  }
+  {
+    auto& q = currentPool == this ? *_queues[currentWorker] : _injected;
+    auto lock = std::lock_guard<std::mutex>(q.mutex);
+    q.tasks.push_back(std::move(task));
+  }
+  _wake.notify_one();
+}
+
+void ThreadPool::wait()
+{
+  auto lock = std::unique_lock<std::mutex>(_mutex);
+  _idle.wait(lock, [this] { return _pending == 0; });
+  if (_error) {
+    auto error = _error;
+    _error = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+bool ThreadPool::runOne(size_t self)
+{
+  auto task = std::function<void()>();
+  auto take = [&task](Queue& q, bool newest) {
+    auto lock = std::lock_guard<std::mutex>(q.mutex);
+    if (q.tasks.empty()) {
+      return;
+    }
+    if (newest) {
+      task = std::move(q.tasks.back());
+      q.tasks.pop_back();
+    } else {
+      task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+    }
+  };
+  // own tasks newest first, shared and stolen ones oldest first
+  take(*_queues[self], true);
+  if (!task) {
+    take(_injected, false);
+  }
+  for (size_t i = 1; i < _queues.size() && !task; ++i) {
+    take(*_queues[(self + i) % _queues.size()], false);
+  }
+  if (!task) {
+    return false;
+  }
+  {
+    auto lock = std::lock_guard<std::mutex>(_mutex);
+    --_queued;
+  }
+  auto error = std::exception_ptr();
+  try {
+    task();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  auto lock = std::lock_guard<std::mutex>(_mutex);
+  if (error && !_error) {
+    _error = error;
+  }
+  if (--_pending == 0) {
+    _idle.notify_all();
+  }
+  return true;
+}
+
+void ThreadPool::loop(size_t self)
+{
+  currentPool = this;
+  currentWorker = self;
+  while (true) {
+    if (runOne(self)) {
+      continue;
+    }
+    auto lock = std::unique_lock<std::mutex>(_mutex);
+    _wake.wait(lock, [this] { return _stop || _queued > 0; });
+    if (_stop && _queued == 0) {
+      return;
+    }
+  }
+}
+}
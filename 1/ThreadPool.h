@@ -0,0 +1,78 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nonstd
+{
+/**
+ * @brief Fixed set of threads running tasks with work stealing
+ *
+ * @details
+ * Every worker has its own deque. Tasks submitted by a worker go to its own
+ * deque and are taken newest first. Tasks submitted from outside go to one
+ * shared queue and start in submission order, so callers control which run
+ * first. A worker with nothing of its own takes from the shared queue, then
+ * steals the oldest task of another worker, so a few long tasks don't leave
+ * the rest of the pool idle.
+ */
+class ThreadPool
+{
+public:
+  /**
+   * @param threads number of workers, 0 means one per hardware thread
+   */
+  explicit ThreadPool(size_t threads = 0);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool(ThreadPool&&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ThreadPool& operator=(ThreadPool&&) = delete;
+  ~ThreadPool();
+
+  size_t size() const
+  {
+    return _workers.size();
+  }
+
+  void submit(std::function<void()> task);
+
+  /**
+   * @brief Wait until every submitted task, and the ones they submit, is done
+   *
+   * @details
+   * Rethrows the first exception a task threw.
+   */
+  void wait();
+
+private:
+  struct Queue
+  {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool runOne(size_t self);
+  void loop(size_t self);
+
+  std::vector<std::unique_ptr<Queue>> _queues;
+  // tasks submitted from outside the pool
+  Queue _injected;
+  std::vector<std::thread> _workers;
+  std::mutex _mutex;
+  std::condition_variable _wake;
+  std::condition_variable _idle;
+  size_t _queued = 0;
+  size_t _pending = 0;
+  bool _stop = false;
+  std::exception_ptr _error;
+};
+}
+
+#endif
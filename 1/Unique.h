@@ -0,0 +1,131 @@
+#ifndef UNIQUE_H
+#define UNIQUE_H
+
+#include <string_view>
+#include <vector>
+
+#include "CaseFold.h"
+
+namespace nonstd
+{
+/**
+ * @brief Set of case-insensitive line fingerprints
+ *
+ * @details
+ * Open addressing table of (hash of folded bytes, line index). Equal hashes
+ * are confirmed with compare(), so hash collisions never drop a line.
+ */
+class FingerprintSet
+{
+public:
+  explicit FingerprintSet(size_t expected = 0)
+  {
+    reserve(expected);
+  }
+
+  /**
+   * @brief Insert line 'index' unless an equal line is already there
+   *
+   * @tparam View callable giving std::string_view of a line by index
+   *
+   * @return true if inserted
+   */
+  template<typename View>
+  bool insert(std::string_view line, size_t index, View view)
+  {
+    if ((_size + 1) * 2 > _slots.size()) {
+      reserve(_slots.size());
+    }
+    auto hash = foldedHash(line.data(), line.size());
+    auto mask = _slots.size() - 1;
+    for (auto i = hash & mask;; i = (i + 1) & mask) {
+      auto& slot = _slots[i];
+      if (slot.index == empty) {
+        slot = Slot{ hash, index };
+        ++_size;
+        return true;
+      }
+      if (slot.hash == hash) {
+        auto other = view(slot.index);
+        if (compare(other.data(), other.size(), line.data(), line.size()) ==
+            0) {
+          return false;
+        }
+      }
+    }
+  }
+
+  size_t size() const
+  {
+    return _size;
+  }
+
+  void clear()
+  {
+    _slots.assign(_slots.size(), Slot{ 0, empty });
+    _size = 0;
+  }
+
+private:
+  static constexpr size_t empty = SIZE_MAX;
+
+  struct Slot
+  {
+    uint64_t hash;
+    size_t index;
+  };
+
+  void reserve(size_t count)
+  {
+    size_t capacity = 16;
+    while (capacity < count * 2) {
+      capacity *= 2;
+    }
+    if (capacity <= _slots.size()) {
+      return;
+    }
+    auto old = std::move(_slots);
+    _slots.assign(capacity, Slot{ 0, empty });
+    for (const auto& s : old) {
+      if (s.index != empty) {
+        for (auto i = s.hash & (capacity - 1);; i = (i + 1) & (capacity - 1)) {
+          if (_slots[i].index == empty) {
+            _slots[i] = s;
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<Slot> _slots;
+  size_t _size = 0;
+};
+
+/**
+ * @brief Drop case-insensitive duplicates, first occurrences keep their order
+ *
+ * @tparam T line type
+ * @tparam View callable giving std::string_view of a line
+ */
+template<typename T, typename View>
+void uniqueLines(std::vector<T>& lines, View view)
+{
+  auto set = FingerprintSet(lines.size());
+  size_t out = 0;
+  for (size_t i = 0; i < lines.size(); ++i) {
+    auto kept = set.insert(view(lines[i]), out, [&](size_t index) {
+      return view(lines[index]);
+    });
+    if (kept) {
+      if (out != i) {
+        lines[out] = std::move(lines[i]);
+      }
+      ++out;
+    }
+  }
+  lines.erase(lines.begin() + out, lines.end());
+}
+}
+
+#endif
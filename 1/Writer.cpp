@@ -0,0 +1,212 @@
+#include "Writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <string.h>
+#include <cstdio>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace nonstd
+{
+Writer::Writer(const std::string& path,
+               size_t bufferSize,
+               bool sync,
+               bool append,
+               Compression compression) :
+  _fd(open(path.c_str(),
+           O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC),
+           0644)),
+  _sync(sync),
+  _capacity(std::max<size_t>(bufferSize, 1)),
+  _buffer(new char[_capacity])
+{
+  if (_fd < 0) {
+    throw "can't open output file";
+  }
+  if (compression != Compression::None) {
+    try {
+      _compressor = std::make_unique<Compressor>(compression, _fd);
+    } catch (...) {
+      ::close(_fd);
+      throw;
+    }
+  }
+}
+
+Writer::~Writer()
+{
+  if (_fd >= 0) {
+    try {
+      flush();
+      if (_compressor) {
+        _compressor->finish();
+      }
+    } catch (...) {
+    }
+    ::close(_fd);
+  }
+}
+
+void Writer::line(std::string_view l)
+{
+  if (l.size() + 1 <= _capacity - _used) {
+    memcpy(_buffer.get() + _used, l.data(), l.size());
+    _used += l.size();
+    _buffer[_used++] = '\n';
+    return;
+  }
+  if (l.size() + 1 <= _capacity) {
+    flush();
+    line(l);
+    return;
+  }
+  writeAll(l);
+}
+
+void Writer::flush()
+{
+  writeAll(std::string_view());
+}
+
+void Writer::close()
+{
+  flush();
+  if (_compressor) {
+    _compressor->finish();
+  }
+  if (_sync && fsync(_fd) != 0) {
+    throw "can't sync output file";
+  }
+  auto fd = _fd;
+  _fd = -1;
+  if (::close(fd) != 0) {
+    throw "can't close output file";
+  }
+}
+
+void Writer::writeAll(std::string_view extra)
+{
+  if (_compressor) {
+    _compressor->write(std::string_view(_buffer.get(), _used));
+    if (!extra.empty()) {
+      _compressor->write(extra);
+      _compressor->write("\n");
+    }
+    _used = 0;
+    return;
+  }
+  char newline = '\n';
+  iovec parts[3] = { { _buffer.get(), _used },
+                     { const_cast<char*>(extra.data()), extra.size() },
+                     { &newline, extra.empty() ? 0u : 1u } };
+  iovec* part = parts;
+  int count = 3;
+  while (count > 0) {
+    if (part->iov_len == 0) {
+      ++part;
+      --count;
+      continue;
+    }
+    auto n = writev(_fd, part, count);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw "can't write output file";
+    }
+    for (size_t left = n; left > 0 && count > 0;) {
+      auto step = std::min(left, part->iov_len);
+      part->iov_base = static_cast<char*>(part->iov_base) + step;
+      part->iov_len -= step;
+      left -= step;
+      if (part->iov_len == 0) {
+        ++part;
+        --count;
+      }
+    }
+  }
+  _used = 0;
+}
+
+AtomicFile::AtomicFile(const std::string& path) :
+  _path(path), _temporary(path + "_tmpXXXXXX"), _fd(-1)
+{
+  // unique, so writers of the same path don't share a temporary file
+  _fd = mkostemp(&_temporary[0], O_CLOEXEC);
+  if (_fd < 0) {
+    throw "can't open output file";
+  }
+  struct stat s;
+  auto mode = stat(path.c_str(), &s) == 0 ? s.st_mode & 07777 : 0644;
+  if (fchmod(_fd, mode) != 0) {
+    ::close(_fd);
+    unlink(_temporary.c_str());
+    throw "can't open output file";
+  }
+}
+
+AtomicFile::~AtomicFile()
+{
+  if (_fd >= 0) {
+    ::close(_fd);
+    unlink(_temporary.c_str());
+  }
+}
+
+bool AtomicFile::replaceable(const std::string& path)
+{
+  struct stat s;
+  if (stat(path.c_str(), &s) != 0) {
+    return errno == ENOENT;
+  }
+  return S_ISREG(s.st_mode);
+}
+
+void AtomicFile::allocate(uint64_t size)
+{
+  if (size == 0) {
+    return;
+  }
+  auto error = posix_fallocate(_fd, 0, size);
+  if (error == ENOSPC) {
+    throw "no space for output file";
+  }
+  // not every file system supports it, the size is what matters
+  if (error != 0 && ftruncate(_fd, size) != 0) {
+    throw "can't allocate output file";
+  }
+}
+
+void AtomicFile::write(const char* data, size_t size, uint64_t offset)
+{
+  while (size > 0) {
+    auto n = pwrite(_fd, data, size, offset);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw "can't write output file";
+    }
+    data += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+void AtomicFile::commit(bool sync)
+{
+  if (sync && fsync(_fd) != 0) {
+    throw "can't sync output file";
+  }
+  auto fd = _fd;
+  _fd = -1;
+  auto closed = ::close(fd) == 0;
+  if (!closed || std::rename(_temporary.c_str(), _path.c_str()) != 0) {
+    unlink(_temporary.c_str());
+    throw "can't replace output file";
+  }
+}
+}
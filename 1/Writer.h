@@ -0,0 +1,214 @@
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Compression.h"
+#include "Parallel.h"
+
+namespace nonstd
+{
+/**
+ * @brief Line writer straight to a file descriptor
+ *
+ * @details
+ * Lines are batched into one buffer which is written when it is full. Lines
+ * which don't fit into an empty buffer are written in place together with the
+ * buffered data by a single writev().
+ */
+class Writer
+{
+public:
+  static constexpr size_t defaultBufferSize = 1024 * 1024;
+
+  /**
+   * @brief Create or truncate file
+   *
+   * @param path output file
+   * @param bufferSize bytes batched per write
+   * @param sync fsync() the file on close()
+   * @param append keep the content and write after it
+   * @param compression stream format written, a gzip append adds a member
+   */
+  explicit Writer(const std::string& path,
+                  size_t bufferSize = defaultBufferSize,
+                  bool sync = false,
+                  bool append = false,
+                  Compression compression = Compression::None);
+  Writer(const Writer&) = delete;
+  Writer(Writer&&) = delete;
+  Writer& operator=(const Writer&) = delete;
+  Writer& operator=(Writer&&) = delete;
+  ~Writer();
+
+  /**
+   * @brief Write line followed by '\n'
+   */
+  void line(std::string_view l);
+
+  void flush();
+
+  /**
+   * @brief Flush, optionally fsync, and close the file
+   */
+  void close();
+
+private:
+  void writeAll(std::string_view extra);
+
+  int _fd;
+  bool _sync;
+  size_t _capacity;
+  size_t _used = 0;
+  std::unique_ptr<char[]> _buffer;
+  std::unique_ptr<Compressor> _compressor;
+};
+
+/**
+ * @brief Output which replaces 'path' only once it is complete
+ *
+ * @details
+ * Everything goes to temporary() first, a unique file next to 'path', and
+ * commit() renames it over 'path' with the mode the old file had, so readers
+ * see either the old file or the whole new one. Destroyed before commit() the
+ * temporary file is removed.
+ */
+class AtomicFile
+{
+public:
+  explicit AtomicFile(const std::string& path);
+  AtomicFile(const AtomicFile&) = delete;
+  AtomicFile(AtomicFile&&) = delete;
+  AtomicFile& operator=(const AtomicFile&) = delete;
+  AtomicFile& operator=(AtomicFile&&) = delete;
+  ~AtomicFile();
+
+  /**
+   * @brief Whether 'path' can be replaced by rename()
+   *
+   * @details
+   * True for a missing or regular file, not for e.g. /dev/null or a pipe.
+   */
+  static bool replaceable(const std::string& path);
+
+  const std::string& temporary() const
+  {
+    return _temporary;
+  }
+
+  /**
+   * @brief Make the temporary file 'size' bytes, allocating its blocks
+   *
+   * @details
+   * Throws when the disk is full, file systems which can't allocate only get
+   * the size.
+   */
+  void allocate(uint64_t size);
+
+  /**
+   * @brief Write 'size' bytes at 'offset', safe to call from many threads
+   */
+  void write(const char* data, size_t size, uint64_t offset);
+
+  /**
+   * @brief Optionally fsync, then rename the temporary file over 'path'
+   */
+  void commit(bool sync);
+
+private:
+  std::string _path;
+  std::string _temporary;
+  int _fd;
+};
+
+/**
+ * @brief Write view(i) for i in [0, count) as lines on 'threads' threads
+ *
+ * @details
+ * A first parallel pass sums the bytes of every thread's contiguous range of
+ * lines, their prefix sum is where each range starts in the output. The file
+ * is then allocated at its final size and every thread formats its range into
+ * its own buffer and pwrite()s it in place. Output goes through AtomicFile,
+ * the first error of a thread is rethrown once all of them are done.
+ */
+template<typename View>
+void writeParallel(const std::string& path,
+                   size_t count,
+                   View view,
+                   size_t threads,
+                   bool sync = false,
+                   size_t bufferSize = Writer::defaultBufferSize)
+{
+  threads = std::max<size_t>(1, std::min(threads, count));
+  // same split as parallelFor
+  auto bound = [count, threads](size_t t) {
+    return count / threads * t + std::min(t, count % threads);
+  };
+  // an exception can't leave the threads, the first one is rethrown after
+  auto errors = std::vector<std::exception_ptr>(threads);
+  auto inParallel = [&errors, threads](auto f) {
+    parallelFor(threads, threads, [&](size_t first, size_t last) {
+      try {
+        f(first, last);
+      } catch (...) {
+        errors[first] = std::current_exception();
+      }
+    });
+    for (const auto& e : errors) {
+      if (e) {
+        std::rethrow_exception(e);
+      }
+    }
+  };
+
+  auto offsets = std::vector<uint64_t>(threads + 1, 0);
+  inParallel([&](size_t first, size_t last) {
+    for (auto t = first; t < last; ++t) {
+      for (auto i = bound(t); i < bound(t + 1); ++i) {
+        offsets[t + 1] += view(i).size() + 1;
+      }
+    }
+  });
+  for (size_t t = 0; t < threads; ++t) {
+    offsets[t + 1] += offsets[t];
+  }
+
+  auto file = AtomicFile(path);
+  file.allocate(offsets.back());
+  bufferSize = std::max<size_t>(bufferSize, 1);
+  inParallel([&](size_t first, size_t last) {
+    auto buffer = std::unique_ptr<char[]>(new char[bufferSize]);
+    for (auto t = first; t < last; ++t) {
+      auto offset = offsets[t];
+      size_t used = 0;
+      for (auto i = bound(t); i < bound(t + 1); ++i) {
+        auto l = view(i);
+        if (l.size() + 1 > bufferSize - used) {
+          file.write(buffer.get(), used, offset);
+          offset += used;
+          used = 0;
+          if (l.size() + 1 > bufferSize) {
+            file.write(l.data(), l.size(), offset);
+            file.write("\n", 1, offset + l.size());
+            offset += l.size() + 1;
+            continue;
+          }
+        }
+        std::copy(l.begin(), l.end(), buffer.get() + used);
+        used += l.size();
+        buffer[used++] = '\n';
+      }
+      file.write(buffer.get(), used, offset);
+    }
+  });
+  file.commit(sync);
+}
+}
+
+#endif
@@ -0,0 +1,75 @@
+#include "Corpus.h"
+
+#include <random>
+
+namespace bench
+{
+std::string generate(const Corpus& corpus)
+{
+  auto random = std::mt19937(corpus.seed);
+  auto chance = std::uniform_real_distribution<double>(0, 1);
+  auto length = std::uniform_int_distribution<size_t>(corpus.minLength,
+                                                      corpus.maxLength);
+  auto letter = std::uniform_int_distribution<int>(0, 25);
+  auto number = std::uniform_int_distribution<int>(0, 59);
+  const char* dirs[] = { "usr", "lib", "share", "local", "include", "src" };
+  auto word = [&](size_t n) {
+    auto w = std::string();
+    while (w.size() < n) {
+      auto upper = chance(random) < corpus.upperCase;
+      w += static_cast<char>((upper ? 'A' : 'a') + letter(random));
+    }
+    return w;
+  };
+
+  auto content = std::string();
+  for (size_t i = 0; i < corpus.lines; ++i) {
+    auto l = std::string();
+    auto n = length(random);
+    switch (corpus.shape) {
+      case Corpus::Shape::Words:
+        l = word(n);
+        break;
+      case Corpus::Shape::Logs:
+        l = "2020-02-24 " + std::to_string(10 + number(random) % 14) + ":" +
+            std::to_string(number(random)) + ":" +
+            std::to_string(number(random)) + " " + word(4) + " ";
+        l += word(n > l.size() ? n - l.size() : 1);
+        break;
+      case Corpus::Shape::Paths:
+        while (l.size() < n) {
+          l += "/" + word(1) + dirs[number(random) % 6];
+        }
+        l += "/file" + std::to_string(i % 1000);
+        break;
+    }
+    if (chance(random) < corpus.hitRate) {
+      l.insert(length(random) % (l.size() + 1), corpus.pattern);
+    }
+    content += l;
+    content += '\n';
+  }
+  return content;
+}
+
+std::string write(const Corpus& corpus, const std::string& name)
+{
+  auto path =
+    (std::experimental::filesystem::temp_directory_path() / name).string();
+  auto file = std::ofstream(path);
+  file << generate(corpus);
+  return path;
+}
+
+nonstd::Lines lines(const std::string& content)
+{
+  auto result = nonstd::Lines();
+  size_t begin = 0;
+  for (auto end = content.find('\n'); end != std::string::npos;
+       end = content.find('\n', begin)) {
+    result.emplace_back(content.data() + begin, end - begin);
+    begin = end + 1;
+  }
+  return result;
+}
+}
@@ -0,0 +1,48 @@
+#ifndef BENCHMARKS_CORPUS_H
+#define BENCHMARKS_CORPUS_H
+
+#include <string>
+
+#include "../Text.h"
+
+namespace bench
+{
+/**
+ * @brief Parameters of a synthetic input file
+ */
+struct Corpus
+{
+  enum class Shape { Words, Logs, Paths };
+
+  size_t lines = 100000;
+  Shape shape = Shape::Words;
+  // length of the generated text of a line before the pattern is inserted
+  size_t minLength = 8;
+  size_t maxLength = 64;
+  // fraction of lines containing the pattern once
+  double hitRate = 0.1;
+  // probability of a letter being upper case
+  double upperCase = 0.3;
+  std::string pattern = "ABC";
+  unsigned seed = 1;
+};
+
+/**
+ * @brief Generate content of a corpus, every line ends with '\n'
+ */
+std::string generate(const Corpus& corpus);
+
+/**
+ * @brief Generate corpus into a file in the temporary directory
+ *
+ * @return path of the file
+ */
+std::string write(const Corpus& corpus, const std::string& name);
+
+/**
+ * @brief Split generated content into lines
+ */
+nonstd::Lines lines(const std::string& content);
+}
+
+#endif
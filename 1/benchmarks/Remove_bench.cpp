@@ -0,0 +1,150 @@
+#include <benchmark/benchmark.h>
+
+#include <regex>
+
+#include "../Pattern.h"
+#include "../PatternSet.h"
+#include "../Text.h"
+#include "Corpus.h"
+
+namespace
+{
+// the implementation nonstd::remove had before the compiled Pattern
+void regexRemove(nonstd::string& l, const std::string& p)
+{
+  std::regex specialChars{ R"([-[\]{}()*+?.,\^$|#\s])" };
+  auto sanitized = std::regex_replace(p, specialChars, R"(\$&)");
+  l = std::regex_replace(l, std::regex(sanitized), "");
+}
+
+const auto lines = [] {
+  auto corpus = bench::Corpus();
+  corpus.lines = 10000;
+  corpus.shape = bench::Corpus::Shape::Logs;
+  return bench::lines(bench::generate(corpus));
+}();
+}
+
+static void BM_RemoveRegex(benchmark::State& state)
+{
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto copy = lines;
+    state.ResumeTiming();
+    for (auto& l : copy) {
+      regexRemove(l, "ABC");
+    }
+    benchmark::DoNotOptimize(copy.data());
+  }
+  state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK(BM_RemoveRegex);
+
+static void BM_RemovePattern(benchmark::State& state)
+{
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto copy = lines;
+    state.ResumeTiming();
+    auto p = nonstd::Pattern("ABC");
+    for (auto& l : copy) {
+      nonstd::remove(l, p);
+    }
+    benchmark::DoNotOptimize(copy.data());
+  }
+  state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK(BM_RemovePattern);
+
+// every case variant in one pass against one pass per variant
+static void BM_RemovePatternIgnoringCase(benchmark::State& state)
+{
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto copy = lines;
+    state.ResumeTiming();
+    auto p = nonstd::Pattern("ABC", true);
+    for (auto& l : copy) {
+      nonstd::remove(l, p);
+    }
+    benchmark::DoNotOptimize(copy.data());
+  }
+  state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK(BM_RemovePatternIgnoringCase);
+
+static void BM_RemoveEveryCaseVariant(benchmark::State& state)
+{
+  auto variants = std::vector<nonstd::Pattern>();
+  for (int bits = 0; bits < 8; ++bits) {
+    auto v = std::string("abc");
+    for (int i = 0; i < 3; ++i) {
+      if (bits & (1 << i)) {
+        v[i] = nonstd::fold(v[i]) - 0x20;
+      }
+    }
+    variants.emplace_back(v);
+  }
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto copy = lines;
+    state.ResumeTiming();
+    for (const auto& p : variants) {
+      for (auto& l : copy) {
+        nonstd::remove(l, p);
+      }
+    }
+    benchmark::DoNotOptimize(copy.data());
+  }
+  state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK(BM_RemoveEveryCaseVariant);
+
+namespace
+{
+std::vector<std::string> makePatterns(size_t count)
+{
+  auto patterns = std::vector<std::string>();
+  for (size_t i = 0; i < count; ++i) {
+    patterns.push_back("token-" + std::to_string(i * 7919));
+  }
+  patterns.push_back("ABC");
+  return patterns;
+}
+}
+
+static void BM_RemovePatternsInSequence(benchmark::State& state)
+{
+  auto patterns = makePatterns(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto copy = lines;
+    state.ResumeTiming();
+    for (const auto& p : patterns) {
+      auto compiled = nonstd::Pattern(p);
+      for (auto& l : copy) {
+        nonstd::remove(l, compiled);
+      }
+    }
+    benchmark::DoNotOptimize(copy.data());
+  }
+  state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK(BM_RemovePatternsInSequence)->Arg(10)->Arg(100);
+
+static void BM_RemovePatternSet(benchmark::State& state)
+{
+  auto patterns = makePatterns(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto copy = lines;
+    state.ResumeTiming();
+    auto set = nonstd::PatternSet(patterns);
+    for (auto& l : copy) {
+      nonstd::remove(l, set);
+    }
+    benchmark::DoNotOptimize(copy.data());
+  }
+  state.SetItemsProcessed(state.iterations() * lines.size());
+}
+BENCHMARK(BM_RemovePatternSet)->Arg(10)->Arg(100);
@@ -0,0 +1,35 @@
+#include <benchmark/benchmark.h>
+
+#include "../Text.h"
+#include "Corpus.h"
+
+namespace
+{
+nonstd::Lines makeLines(bench::Corpus::Shape shape, size_t count)
+{
+  auto corpus = bench::Corpus();
+  corpus.lines = count;
+  corpus.shape = shape;
+  corpus.hitRate = 0;
+  return bench::lines(bench::generate(corpus));
+}
+}
+
+static void BM_SortLines(benchmark::State& state)
+{
+  auto shape = static_cast<bench::Corpus::Shape>(state.range(0));
+  auto lines = makeLines(shape, 200000);
+  auto algorithm = static_cast<nonstd::SortAlgorithm>(state.range(1));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto copy = lines;
+    state.ResumeTiming();
+    nonstd::sort(copy, 1, algorithm);
+    benchmark::DoNotOptimize(copy.data());
+  }
+  state.SetItemsProcessed(state.iterations() * lines.size());
+}
+// corpus shape: Words, Logs, Paths; algorithm: Comparison, PrefixKey, Radix
+BENCHMARK(BM_SortLines)
+  ->ArgsProduct({ { 0, 1, 2 }, { 0, 1, 2 } })
+  ->Unit(benchmark::kMillisecond);
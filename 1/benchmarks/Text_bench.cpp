@@ -0,0 +1,156 @@
+#include <benchmark/benchmark.h>
+
+#include <map>
+
+#include "../Text.h"
+#include "../TextStream.h"
+#include "Corpus.h"
+
+namespace
+{
+const size_t lineCount = 200000;
+
+// corpus files are generated once per hit rate (in percent)
+const std::string& corpus(int hitRate)
+{
+  static auto paths = std::map<int, std::string>();
+  auto& path = paths[hitRate];
+  if (path.empty()) {
+    auto c = bench::Corpus();
+    c.lines = lineCount;
+    c.shape = bench::Corpus::Shape::Logs;
+    c.hitRate = hitRate / 100.0;
+    path = bench::write(c, "ci_string_bench_" + std::to_string(hitRate));
+  }
+  return path;
+}
+
+void report(benchmark::State& state, const std::string& path)
+{
+  state.SetItemsProcessed(state.iterations() * lineCount);
+  state.SetBytesProcessed(state.iterations() *
+                          std::experimental::filesystem::file_size(path));
+}
+
+// operations run when written, the output itself is discarded
+const char* const discard = "/dev/null";
+
+const auto storages = std::vector<int64_t>{
+  static_cast<int64_t>(nonstd::Storage::Strings),
+  static_cast<int64_t>(nonstd::Storage::Mapped),
+  static_cast<int64_t>(nonstd::Storage::Arena)
+};
+}
+
+// storage, threads
+static void BM_Load(benchmark::State& state)
+{
+  const auto& path = corpus(10);
+  for (auto _ : state) {
+    auto text = Text(path,
+                     static_cast<nonstd::Storage>(state.range(0)),
+                     state.range(1));
+    benchmark::ClobberMemory();
+  }
+  report(state, path);
+}
+BENCHMARK(BM_Load)
+  ->ArgsProduct({ storages, { 1, 4 } })
+  ->Unit(benchmark::kMillisecond)
+  ->UseRealTime();
+
+// storage, hit rate in percent
+static void BM_Remove(benchmark::State& state)
+{
+  const auto& path = corpus(state.range(1));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto text = Text(path, static_cast<nonstd::Storage>(state.range(0)));
+    state.ResumeTiming();
+    text.remove("ABC");
+    text.toFile(discard);
+  }
+  report(state, path);
+}
+BENCHMARK(BM_Remove)
+  ->ArgsProduct({ storages, { 0, 10, 100 } })
+  ->Unit(benchmark::kMillisecond);
+
+// storage, sort algorithm
+static void BM_Sort(benchmark::State& state)
+{
+  const auto& path = corpus(10);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto text = Text(path, static_cast<nonstd::Storage>(state.range(0)));
+    text.setSortAlgorithm(static_cast<nonstd::SortAlgorithm>(state.range(1)));
+    state.ResumeTiming();
+    text.sort();
+    text.toFile(discard);
+  }
+  report(state, path);
+}
+BENCHMARK(BM_Sort)
+  ->ArgsProduct({ storages, { 0, 1, 2 } })
+  ->Unit(benchmark::kMillisecond);
+
+// storage, threads
+static void BM_ToFile(benchmark::State& state)
+{
+  const auto& path = corpus(10);
+  auto text = Text(path, static_cast<nonstd::Storage>(state.range(0)));
+  text.setThreads(state.range(1));
+  for (auto _ : state) {
+    text.toFile();
+  }
+  report(state, path);
+}
+BENCHMARK(BM_ToFile)
+  ->ArgsProduct({ storages, { 1, 2, 4 } })
+  ->Unit(benchmark::kMillisecond)
+  ->UseRealTime();
+
+// storage, threads
+static void BM_Pipeline(benchmark::State& state)
+{
+  const auto& path = corpus(10);
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto text = Text(path, static_cast<nonstd::Storage>(state.range(0)));
+    text.setThreads(state.range(1));
+    state.ResumeTiming();
+    for (auto p : { "ABC", "secret", "host-1", "user=", "token" }) {
+      text.remove(p);
+    }
+    text.sort();
+    text.toFile(discard);
+  }
+  report(state, path);
+}
+BENCHMARK(BM_Pipeline)
+  ->ArgsProduct({ storages, { 1, 2 } })
+  ->Unit(benchmark::kMillisecond);
+
+// io backend
+static void BM_StreamRemove(benchmark::State& state)
+{
+  auto backend = static_cast<nonstd::IoBackend>(state.range(0));
+  if (backend == nonstd::IoBackend::Uring &&
+      !nonstd::AsyncIo::uringAvailable()) {
+    state.SkipWithError("io_uring unavailable");
+    return;
+  }
+  const auto& path = corpus(10);
+  for (auto _ : state) {
+    auto text = TextStream(path);
+    text.setIoBackend(backend);
+    text.remove("ABC");
+    text.toFile(path + "_streamed");
+  }
+  report(state, path);
+}
+BENCHMARK(BM_StreamRemove)
+  ->Arg(static_cast<int64_t>(nonstd::IoBackend::Uring))
+  ->Arg(static_cast<int64_t>(nonstd::IoBackend::Threads))
+  ->Unit(benchmark::kMillisecond)
+  ->UseRealTime();
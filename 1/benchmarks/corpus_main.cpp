@@ -0,0 +1,33 @@
+#include <iostream>
+
+#include "Corpus.h"
+
+// corpus <path> [lines] [words|logs|paths] [hit rate] [upper case rate]
+int main(int argc, char** argv)
+{
+  if (argc < 2) {
+    std::cerr << "usage: corpus <path> [lines] [words|logs|paths] [hit rate] "
+                 "[upper case rate]"
+              << std::endl;
+    return 1;
+  }
+  auto corpus = bench::Corpus();
+  if (argc > 2) {
+    corpus.lines = std::stoul(argv[2]);
+  }
+  if (argc > 3) {
+    auto shape = std::string(argv[3]);
+    corpus.shape = shape == "logs"    ? bench::Corpus::Shape::Logs
+                   : shape == "paths" ? bench::Corpus::Shape::Paths
+                                      : bench::Corpus::Shape::Words;
+  }
+  if (argc > 4) {
+    corpus.hitRate = std::stod(argv[4]);
+  }
+  if (argc > 5) {
+    corpus.upperCase = std::stod(argv[5]);
+  }
+  auto file = std::ofstream(argv[1]);
+  file << bench::generate(corpus);
+  return file.good() ? 0 : 1;
+}
@@ -1,11 +1,148 @@
+#include <fstream>
+#include <getopt.h>
 #include <iostream>
 
-#include "Text.h"
+#include "Batch.h"
+#include "Index.h"
+#include "Merge.h"
+
+namespace
+{
+void usage(const char* name)
+{
+  std::cerr << "usage: " << name
+            << " [-r pattern]... [-I] [-s] [-u] [-j threads] [-b split bytes]"
+               " [-l list] [-i] [-S stats] [-m output] [-x] [-p prefix] [-z]"
+               " [file or directory]...\n"
+               "  -r  remove pattern from every line, may be repeated\n"
+               "  -I  remove patterns in any ASCII case\n"
+               "  -s  sort lines case-insensitively\n"
+               "  -u  drop lines equal ignoring case to an earlier one\n"
+               "  -j  number of threads, 0 means one per hardware thread\n"
+               "  -b  split files larger than this into parts\n"
+               "  -l  process the files listed one per line in 'list'\n"
+               "  -i  only process lines appended since the last -i run\n"
+               "  -S  write per-stage statistics as JSON to 'stats'\n"
+               "  -m  merge the given sorted files into 'output', only -r, -I"
+               " and -u apply\n"
+               "  -x  write a sorted index next to every output, needs -s\n"
+               "  -p  print lines of the given indexed files starting with"
+               " 'prefix'\n"
+               "  -z  gzip outputs, gzip input is always detected\n"
+               "every file is written next to it with suffix _processed\n";
+}
+}
 
 int main(int argc, char** argv)
 {
-  auto text = Text("/home/roman/repos/test/1/sample.txt");
-  text.remove("ABC");
-  text.sort();
-  text.toFile();
+  auto options = nonstd::BatchOptions();
+  auto paths = std::vector<std::string>();
+  auto statsPath = std::string();
+  auto mergePath = std::string();
+  auto query = std::string();
+  auto querying = false;
+  try {
+    int opt;
+    while ((opt = getopt(argc, argv, "r:Isuj:b:l:iS:m:xp:zh")) != -1) {
+      switch (opt) {
+        case 'r':
+          options.patterns.push_back(optarg);
+          break;
+        case 'I':
+          options.ignoreCase = true;
+          break;
+        case 's':
+          options.sort = true;
+          break;
+        case 'u':
+          options.unique = true;
+          break;
+        case 'j':
+          options.threads = std::stoul(optarg);
+          break;
+        case 'b':
+          options.splitSize = std::max(1ul, std::stoul(optarg));
+          break;
+        case 'l': {
+          auto listed = nonstd::readFileList(optarg);
+          paths.insert(paths.end(), listed.begin(), listed.end());
+          break;
+        }
+        case 'i':
+          options.incremental = true;
+          break;
+        case 'S':
+          statsPath = optarg;
+          break;
+        case 'm':
+          mergePath = optarg;
+          break;
+        case 'x':
+          options.index = true;
+          break;
+        case 'z':
+          options.compression = nonstd::Compression::Gzip;
+          break;
+        case 'p':
+          query = optarg;
+          querying = true;
+          break;
+        default:
+          usage(argv[0]);
+          return opt == 'h' ? 0 : 2;
+      }
+    }
+    if (querying) {
+      for (auto i = optind; i < argc; ++i) {
+        auto index = nonstd::SortedIndex(argv[i]);
+        auto found = index.prefix(query);
+        for (auto l = found.first; l < found.second; ++l) {
+          std::cout << index.line(l) << '\n';
+        }
+      }
+      return 0;
+    }
+    auto compressed = options.compression != nonstd::Compression::None;
+    if (options.index && (!options.sort || compressed)) {
+      usage(argv[0]);
+      return 2;
+    }
+    if (!mergePath.empty()) {
+      paths.insert(paths.end(), argv + optind, argv + argc);
+      if (paths.empty()) {
+        usage(argv[0]);
+        return 2;
+      }
+      nonstd::mergeSorted(paths,
+                          mergePath,
+                          options.patterns,
+                          options.unique,
+                          options.ignoreCase);
+      return 0;
+    }
+    for (auto i = optind; i < argc; ++i) {
+      if (std::experimental::filesystem::is_directory(argv[i])) {
+        auto listed = nonstd::listFiles(argv[i], options.suffix);
+        paths.insert(paths.end(), listed.begin(), listed.end());
+      } else {
+        paths.push_back(argv[i]);
+      }
+    }
+    if (paths.empty()) {
+      usage(argv[0]);
+      return 2;
+    }
+    auto report = nonstd::processFiles(paths, options);
+    nonstd::printReport(std::cout, report);
+    if (!statsPath.empty()) {
+      auto stats = std::ofstream(statsPath);
+      nonstd::printStats(stats, report);
+    }
+    return report.failed == 0 ? 0 : 1;
+  } catch (const char* e) {
+    std::cerr << argv[0] << ": " << e << '\n';
+  } catch (const std::exception& e) {
+    std::cerr << argv[0] << ": " << e.what() << '\n';
+  }
+  return 2;
 }
@@ -0,0 +1,154 @@
+#include <gmock/gmock.h>
+
+#include <atomic>
+#include <future>
+#include <sstream>
+
+#include "../Batch.h"
+#include "../ThreadPool.h"
+#include "Files.h"
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::Gt;
+using ::testing::HasSubstr;
+
+namespace fs = std::experimental::filesystem;
+
+namespace
+{
+std::string viaText(const std::string& path, bool sort, bool unique)
+{
+  auto text = Text(path);
+  text.remove(std::vector<std::string>{ "ABC", "e1" });
+  if (unique) {
+    text.unique();
+  }
+  if (sort) {
+    text.sort();
+  }
+  text.toFile(path + "_expected");
+  return tests::readAll(path + "_expected");
+}
+
+nonstd::BatchOptions options(bool sort, bool unique)
+{
+  auto result = nonstd::BatchOptions();
+  result.patterns = { "ABC", "e1" };
+  result.sort = sort;
+  result.unique = unique;
+  result.threads = 3;
+  return result;
+}
+}
+
+TEST(ThreadPool, RunsTasksSubmittedByTasks)
+{
+  auto pool = nonstd::ThreadPool(3);
+  auto count = std::atomic<int>(0);
+  for (int i = 0; i < 10; ++i) {
+    pool.submit([&pool, &count] {
+      for (int j = 0; j < 10; ++j) {
+        pool.submit([&count] { ++count; });
+      }
+    });
+  }
+  pool.wait();
+  EXPECT_THAT(count.load(), Eq(100));
+}
+
+TEST(ThreadPool, StartsOutsideTasksInSubmissionOrder)
+{
+  auto pool = nonstd::ThreadPool(1);
+  auto release = std::promise<void>();
+  auto released = release.get_future().share();
+  // keeps the worker busy until everything is queued
+  pool.submit([released] { released.wait(); });
+  auto order = std::vector<int>();
+  for (int i = 0; i < 10; ++i) {
+    pool.submit([&order, i] { order.push_back(i); });
+  }
+  release.set_value();
+  pool.wait();
+  EXPECT_THAT(order, ElementsAre(0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+}
+
+TEST(ThreadPool, RethrowsFromWait)
+{
+  auto pool = nonstd::ThreadPool(2);
+  pool.submit([] { throw "failed"; });
+  pool.submit([] {});
+  EXPECT_ANY_THROW(pool.wait());
+  pool.submit([] {});
+  EXPECT_NO_THROW(pool.wait());
+}
+
+TEST(Batch, SplitFilesGiveTextOutput)
+{
+  auto path = tests::writeFile("ci_string_batch_split", tests::sample(5000));
+  for (auto sort : { false, true }) {
+    for (auto unique : { false, true }) {
+      auto expected = viaText(path, sort, unique);
+      auto o = options(sort, unique);
+      o.splitSize = 1000;
+      auto report = nonstd::processFiles({ path }, o);
+      ASSERT_THAT(report.failed, Eq(0u));
+      EXPECT_THAT(report.files[0].parts > 1, Eq(sort || !unique));
+      EXPECT_THAT(tests::readAll(path + "_processed"), Eq(expected));
+      EXPECT_FALSE(tests::hasTemporary(path + "_processed"));
+    }
+  }
+}
+
+TEST(Batch, IdleWorkersStealParts)
+{
+  auto path = tests::writeFile("ci_string_batch_steal", tests::sample(20000));
+  auto o = options(true, false);
+  o.splitSize = 1000;
+  auto report = nonstd::processFiles({ path }, o);
+  ASSERT_THAT(report.failed, Eq(0u));
+  // only the worker running the file's job gets its parts without stealing
+  EXPECT_THAT(report.files[0].threads, Gt(1u));
+  EXPECT_THAT(tests::readAll(path + "_processed"),
+              Eq(viaText(path, true, false)));
+}
+
+TEST(Batch, FailedJoinKeepsOldOutput)
+{
+  auto path = tests::writeFile("ci_string_batch_keep", tests::sample(5000));
+  tests::writeFile("ci_string_batch_keep_processed", "old\n");
+  // unsorted output can't be indexed
+  auto o = options(false, false);
+  o.splitSize = 1000;
+  o.index = true;
+  auto report = nonstd::processFiles({ path }, o);
+  EXPECT_THAT(report.failed, Eq(1u));
+  EXPECT_THAT(tests::readAll(path + "_processed"), Eq("old\n"));
+  EXPECT_FALSE(tests::hasTemporary(path + "_processed"));
+}
+
+TEST(Batch, ProcessesDirectoryAndReportsFailures)
+{
+  auto dir = tests::tempPath("ci_string_batch_dir");
+  fs::remove_all(dir);
+  fs::create_directories(dir + "/nested");
+  tests::writeFile("ci_string_batch_dir/a", tests::sample(100));
+  tests::writeFile("ci_string_batch_dir/nested/b", tests::sample(300));
+  tests::writeFile("ci_string_batch_dir/old_processed", "skipped\n");
+
+  auto paths = nonstd::listFiles(dir);
+  ASSERT_THAT(paths.size(), Eq(2u));
+  paths.push_back(dir + "/missing");
+  auto report = nonstd::processFiles(paths, options(true, false));
+  EXPECT_THAT(report.failed, Eq(1u));
+  EXPECT_THAT(report.files[2].error, Eq("invalid file"));
+  for (size_t i = 0; i < 2; ++i) {
+    EXPECT_THAT(tests::readAll(paths[i] + "_processed"),
+                Eq(viaText(paths[i], true, false)));
+  }
+
+  auto printed = std::ostringstream();
+  nonstd::printReport(printed, report);
+  EXPECT_THAT(printed.str(), HasSubstr("total\t2 files"));
+  EXPECT_THAT(printed.str(), HasSubstr("1 failed"));
+}
@@ -0,0 +1,109 @@
+#include <gmock/gmock.h>
+
+#include <random>
+
+#include "../CaseFold.h"
+#include "../Text.h"
+
+using ::testing::Eq;
+using ::testing::Gt;
+using ::testing::Lt;
+using namespace nonstd;
+
+TEST(CaseFold, FoldsOnlyAsciiLetters)
+{
+  EXPECT_THAT(fold('A'), Eq('a'));
+  EXPECT_THAT(fold('Z'), Eq('z'));
+  EXPECT_THAT(fold('a'), Eq('a'));
+  EXPECT_THAT(fold('@'), Eq('@'));
+  EXPECT_THAT(fold('['), Eq('['));
+  EXPECT_THAT(fold(0xc4), Eq(0xc4));
+}
+
+TEST(Compare, UsesOnlyGivenNumberOfBytes)
+{
+  EXPECT_THAT(compare("abcX", "ABCY", 3), Eq(0));
+  EXPECT_THAT(ci_traits::compare("abcX", "ABCY", 3), Eq(0));
+  EXPECT_THAT(compare("abcX", "ABCY", 4), Lt(0));
+}
+
+TEST(Compare, TreatsNulAsOrdinaryByte)
+{
+  EXPECT_THAT(compare("a\0b", "A\0c", 3), Lt(0));
+  EXPECT_THAT(nonstd::string("a\0b", 3),
+              ::testing::Ne(nonstd::string("A\0c", 3)));
+}
+
+TEST(Compare, OrdersPrefixFirst)
+{
+  EXPECT_THAT(compare("abc", 3, "ABCD", 4), Lt(0));
+  EXPECT_THAT(compare("abcd", 4, "ABC", 3), Gt(0));
+  EXPECT_THAT(compare("abc", 3, "ABC", 3), Eq(0));
+}
+
+TEST(Compare, AgreesWithScalarComparisonOnLongLines)
+{
+  auto random = std::mt19937(3);
+  auto byte = std::uniform_int_distribution<int>(0, 255);
+  auto position = std::uniform_int_distribution<size_t>(0, 99);
+  for (int i = 0; i < 1000; ++i) {
+    auto a = std::string(100, 'x');
+    for (auto& c : a) {
+      c = static_cast<char>(byte(random));
+    }
+    auto b = a;
+    for (auto& c : b) {
+      c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    b[position(random)] = static_cast<char>(byte(random));
+
+    auto expected = 0;
+    for (size_t j = 0; j < a.size() && expected == 0; ++j) {
+      expected = fold(a[j]) - fold(b[j]);
+    }
+    EXPECT_THAT(compare(a.data(), b.data(), a.size()), Eq(expected));
+  }
+}
+
+TEST(PrefixKey, OrdersLikeCompareWhenDifferent)
+{
+  auto lines = std::vector<std::string>{ "",         "a", "AB",  "abc",
+                                         "abcdefgh", "b", "\xff" };
+  for (size_t i = 0; i + 1 < lines.size(); ++i) {
+    const auto& x = lines[i];
+    const auto& y = lines[i + 1];
+    EXPECT_THAT(prefixKey(x.data(), x.size()),
+                Lt(prefixKey(y.data(), y.size())))
+      << x << " " << y;
+  }
+  EXPECT_THAT(prefixKey("abcdefgh1", 9), Eq(prefixKey("ABCDEFGH2", 9)));
+}
+
+TEST(FindFolded, AgreesWithScalarSearchAtEveryOffset)
+{
+  auto random = std::mt19937(3);
+  auto letter = std::uniform_int_distribution<int>(0, 3);
+  const char letters[] = { 'a', 'A', 'b', 'B' };
+  auto word = [&](size_t n) {
+    auto w = std::string();
+    while (w.size() < n) {
+      w += letters[letter(random)];
+    }
+    return w;
+  };
+  auto scalar = [](const std::string& data, const std::string& p) {
+    for (size_t i = 0; i + p.size() <= data.size(); ++i) {
+      if (compare(data.data() + i, p.data(), p.size()) == 0) {
+        return i;
+      }
+    }
+    return size_t(SIZE_MAX);
+  };
+  for (int i = 0; i < 2000; ++i) {
+    auto data = word(i % 100);
+    auto pattern = word(1 + i % 6);
+    EXPECT_THAT(findFolded(data.data(), data.size(), pattern.data(),
+                           pattern.size()),
+                Eq(scalar(data, pattern)));
+  }
+}
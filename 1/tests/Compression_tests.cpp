@@ -0,0 +1,107 @@
+#include <gmock/gmock.h>
+
+#include <zlib.h>
+
+#include "../Compression.h"
+#include "../Text.h"
+#include "Files.h"
+
+using ::testing::Eq;
+
+namespace
+{
+// gzip written by zlib itself, 'members' times appended
+std::string writeGzip(const std::string& name,
+                      const std::string& content,
+                      int members = 1)
+{
+  auto path = tests::tempPath(name);
+  std::experimental::filesystem::remove(path);
+  for (int i = 0; i < members; ++i) {
+    auto file = gzopen(path.c_str(), "ab");
+    gzwrite(file, content.data(), content.size());
+    gzclose(file);
+  }
+  return path;
+}
+
+std::string decompress(const std::string& path)
+{
+  auto in = nonstd::Decompressor(path);
+  auto result = std::string();
+  char buffer[4096];
+  while (auto n = in.read(buffer, sizeof(buffer))) {
+    result.append(buffer, n);
+  }
+  return result;
+}
+
+std::string process(const std::string& path, nonstd::Storage storage)
+{
+  auto text = Text(path, storage);
+  text.remove("ABC");
+  text.sort();
+  text.toFile(path + "_processed");
+  return tests::readAll(path + "_processed");
+}
+}
+
+TEST(Compression, DetectsFormatByMagicBytes)
+{
+  auto plain = tests::writeFile("ci_string_plain", "\x1f");
+  auto zstd = tests::writeFile("ci_string_zstd", "\x28\xb5\x2f\xfd rest");
+  auto gzip = writeGzip("ci_string_gzip", "a\n");
+  EXPECT_TRUE(nonstd::detectCompression(plain) == nonstd::Compression::None);
+  EXPECT_TRUE(nonstd::detectCompression(zstd) == nonstd::Compression::Zstd);
+  EXPECT_TRUE(nonstd::detectCompression(gzip) == nonstd::Compression::Gzip);
+#ifndef HAVE_ZSTD
+  EXPECT_THROW(nonstd::Decompressor{ zstd }, const char*);
+  EXPECT_THROW(Text{ zstd }, const char*);
+#endif
+}
+
+TEST(Compression, ReadsConcatenatedGzipMembers)
+{
+  auto content = tests::sample(100000);
+  auto path = writeGzip("ci_string_gzip_members", content, 3);
+  EXPECT_THAT(decompress(path), Eq(content + content + content));
+}
+
+TEST(Compression, TextLoadsGzipLikePlainInput)
+{
+  // no final newline and a line longer than a decompressed block
+  auto content = tests::sample(50000) +
+                 std::string(nonstd::Decompressor::blockSize + 10, 'x') +
+                 "\nlast";
+  auto plain = tests::writeFile("ci_string_gzip_text", content);
+  auto gzip = writeGzip("ci_string_gzip_text.gz", content);
+  for (auto storage : { nonstd::Storage::Strings,
+                        nonstd::Storage::Mapped,
+                        nonstd::Storage::Arena }) {
+    EXPECT_THAT(process(gzip, storage), Eq(process(plain, storage)));
+  }
+}
+
+TEST(Compression, WritesGzipOutput)
+{
+  auto path = tests::writeFile("ci_string_gzip_out", tests::sample(20000));
+  auto text = Text(path);
+  text.sort();
+  text.setOutputCompression(nonstd::Compression::Gzip);
+  text.toFile();
+  auto output = path + "_processed";
+  EXPECT_TRUE(nonstd::detectCompression(output) ==
+              nonstd::Compression::Gzip);
+  EXPECT_THAT(decompress(output), Eq(process(path, nonstd::Storage::Strings)));
+}
+
+TEST(Compression, ThrowsOnDamagedGzip)
+{
+  auto content = tests::readAll(writeGzip("ci_string_gzip_bad", "abc\n"));
+  auto truncated = tests::writeFile("ci_string_gzip_truncated",
+                                    content.substr(0, content.size() - 4));
+  EXPECT_THROW(decompress(truncated), const char*);
+  content[content.size() / 2] ^= 0x55;
+  auto corrupt = tests::writeFile("ci_string_gzip_corrupt", content);
+  EXPECT_THROW(decompress(corrupt), const char*);
+}
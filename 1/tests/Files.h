@@ -0,0 +1,60 @@
+#ifndef TESTS_FILES_H
+#define TESTS_FILES_H
+
+#include <experimental/filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+namespace tests
+{
+inline std::string tempPath(const std::string& name)
+{
+  return (std::experimental::filesystem::temp_directory_path() / name)
+    .string();
+}
+
+inline std::string writeFile(const std::string& name,
+                             const std::string& content)
+{
+  auto path = tempPath(name);
+  auto file = std::ofstream(path);
+  file << content;
+  return path;
+}
+
+// whether an AtomicFile temporary of 'path' is left
+inline bool hasTemporary(const std::string& path)
+{
+  namespace fs = std::experimental::filesystem;
+  auto name = fs::path(path).filename().string() + "_tmp";
+  for (const auto& entry :
+       fs::directory_iterator(fs::path(path).parent_path())) {
+    if (entry.path().filename().string().compare(0, name.size(), name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+inline std::string readAll(const std::string& path)
+{
+  auto file = std::ifstream(path);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+// deterministic log-like lines, some of them containing "ABC"
+inline std::string sample(size_t count)
+{
+  const char* words[] = { "zero", "One", "two", "ABCthree", "Four", "fiVe" };
+  auto content = std::string();
+  for (size_t i = 0; i < count; ++i) {
+    content += words[(i * 7) % 6];
+    content += "ABC" + std::to_string((i * 31) % 17) + "\n";
+  }
+  return content;
+}
+}
+
+#endif
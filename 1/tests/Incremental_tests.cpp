@@ -0,0 +1,98 @@
+#include <gmock/gmock.h>
+
+#include "../Incremental.h"
+#include "../Text.h"
+#include "Files.h"
+
+using ::testing::Eq;
+
+namespace
+{
+nonstd::IncrementalOptions options(bool sort)
+{
+  auto result = nonstd::IncrementalOptions();
+  result.patterns = { "ABC", "e1" };
+  result.sort = sort;
+  return result;
+}
+
+std::string viaText(const std::string& path, bool sort)
+{
+  auto text = Text(path);
+  text.remove(std::vector<std::string>{ "ABC", "e1" });
+  if (sort) {
+    text.sort();
+  }
+  text.toFile(path + "_expected");
+  return tests::readAll(path + "_expected");
+}
+
+void append(const std::string& path, const std::string& content)
+{
+  auto file = std::ofstream(path, std::ios::app);
+  file << content;
+}
+}
+
+TEST(Incremental, AppendsNewLinesLikeFullRun)
+{
+  for (auto sort : { false, true }) {
+    auto path = tests::writeFile("ci_string_incremental", tests::sample(300));
+    std::experimental::filesystem::remove(nonstd::statePath(path));
+    auto first = nonstd::processAppended(path, options(sort));
+    EXPECT_FALSE(first.appended);
+    EXPECT_THAT(tests::readAll(path + "_processed"), Eq(viaText(path, sort)));
+
+    append(path, tests::sample(100));
+    auto second = nonstd::processAppended(path, options(sort));
+    EXPECT_TRUE(second.appended);
+    EXPECT_THAT(second.begin, Eq(first.end));
+    EXPECT_THAT(tests::readAll(path + "_processed"), Eq(viaText(path, sort)));
+    EXPECT_FALSE(tests::hasTemporary(path + "_processed"));
+  }
+}
+
+TEST(Incremental, WaitsForUnfinishedLine)
+{
+  auto path = tests::writeFile("ci_string_incremental_tail", "b\nA");
+  std::experimental::filesystem::remove(nonstd::statePath(path));
+  nonstd::processAppended(path, options(true));
+  EXPECT_THAT(tests::readAll(path + "_processed"), Eq("b\n"));
+
+  append(path, "BC\na\n");
+  auto result = nonstd::processAppended(path, options(true));
+  EXPECT_TRUE(result.appended);
+  EXPECT_THAT(tests::readAll(path + "_processed"), Eq("\na\nb\n"));
+}
+
+TEST(Incremental, RunsFullyWhenPrefixOrOptionsChange)
+{
+  auto path = tests::writeFile("ci_string_incremental_changed", "one\ntwo\n");
+  std::experimental::filesystem::remove(nonstd::statePath(path));
+  nonstd::processAppended(path, options(false));
+
+  auto other = options(false);
+  other.patterns.push_back("o");
+  EXPECT_FALSE(nonstd::processAppended(path, other).appended);
+  EXPECT_THAT(tests::readAll(path + "_processed"), Eq("ne\ntw\n"));
+
+  tests::writeFile("ci_string_incremental_changed", "One\ntwo\nthree\n");
+  EXPECT_FALSE(nonstd::processAppended(path, other).appended);
+  EXPECT_THAT(tests::readAll(path + "_processed"), Eq("One\ntw\nthree\n"));
+}
+
+TEST(Incremental, RunsFullyWhenMiddleIsEditedInPlace)
+{
+  auto content = tests::sample(20000);
+  auto path = tests::writeFile("ci_string_incremental_edited", content);
+  std::experimental::filesystem::remove(nonstd::statePath(path));
+  nonstd::processAppended(path, options(true));
+
+  // same length, far from both ends
+  auto middle = content.find("zero", content.size() / 2);
+  content.replace(middle, 4, "ZERO");
+  tests::writeFile("ci_string_incremental_edited", content);
+  append(path, tests::sample(10));
+  EXPECT_FALSE(nonstd::processAppended(path, options(true)).appended);
+  EXPECT_THAT(tests::readAll(path + "_processed"), Eq(viaText(path, true)));
+}
@@ -0,0 +1,76 @@
+#include <gmock/gmock.h>
+
+#include "../Index.h"
+#include "../Text.h"
+#include "Files.h"
+
+using ::testing::Eq;
+
+namespace
+{
+std::vector<std::string> linesOf(const std::string& content)
+{
+  auto lines = std::vector<std::string>();
+  auto in = std::istringstream(content);
+  std::string l;
+  while (std::getline(in, l)) {
+    lines.push_back(l);
+  }
+  return lines;
+}
+
+int compare(const std::string& a, const std::string& b)
+{
+  return nonstd::compare(a.data(), a.size(), b.data(), b.size());
+}
+}
+
+TEST(Index, FindsPrefixesAndRangesLikeScan)
+{
+  auto path = tests::writeFile("ci_string_index",
+                               "b\nB\nbz\n\nA\nabc\n" + tests::sample(500));
+  const char* keys[] = { "", "a", "B", "abc", "fivEABC1", "ONE", "z", "zz" };
+  for (size_t step : { 0, 1, 4, 64 }) {
+    auto text = Text(path, nonstd::Storage::Mapped);
+    text.sort();
+    text.setIndexed(true, step);
+    text.toFile();
+    auto output = path + "_processed";
+    auto lines = linesOf(tests::readAll(output));
+    auto index = nonstd::SortedIndex(output);
+    ASSERT_THAT(index.size(), Eq(lines.size()));
+    for (size_t i = 0; i < lines.size(); ++i) {
+      ASSERT_THAT(std::string(index.line(i)), Eq(lines[i]));
+    }
+    for (std::string key : keys) {
+      size_t first = 0;
+      while (first < lines.size() && compare(lines[first], key) < 0) {
+        ++first;
+      }
+      auto last = first;
+      while (last < lines.size() &&
+             compare(lines[last].substr(0, key.size()), key) == 0) {
+        ++last;
+      }
+      EXPECT_THAT(index.lowerBound(key), Eq(first));
+      EXPECT_THAT(index.prefix(key), Eq(std::make_pair(first, last)));
+      EXPECT_THAT(index.range(key, ""),
+                  Eq(std::make_pair(first, lines.size())));
+    }
+    EXPECT_THAT(index.range("b", "c"), Eq(index.prefix("b")));
+    EXPECT_THAT(index.range("c", "b").second, Eq(index.range("c", "b").first));
+  }
+}
+
+TEST(Index, RefusesUnsortedOrChangedFiles)
+{
+  auto path = tests::writeFile("ci_string_index_unsorted", "b\na\n");
+  EXPECT_THROW(nonstd::buildIndex(path), const char*);
+
+  tests::writeFile("ci_string_index_unsorted", "a\nb\n");
+  nonstd::buildIndex(path);
+  EXPECT_THAT(nonstd::SortedIndex(path).prefix("B"),
+              Eq(std::make_pair<size_t, size_t>(1, 2)));
+  tests::writeFile("ci_string_index_unsorted", "a\nb\nc\n");
+  EXPECT_THROW(nonstd::SortedIndex{ path }, const char*);
+}
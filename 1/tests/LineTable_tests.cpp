@@ -0,0 +1,77 @@
+#include <gmock/gmock.h>
+
+#include "../LineTable.h"
+#include "Files.h"
+
+using ::testing::Eq;
+using namespace nonstd;
+
+TEST(LineTable, IndexesLinesOfMappedFile)
+{
+  auto table = LineTable();
+  table.map(tests::writeFile("ci_string_table_index", "one\n\nthree"));
+  EXPECT_THAT(table.size(), Eq(3));
+  EXPECT_THAT(table.line(0), Eq("one"));
+  EXPECT_THAT(table.line(1), Eq(""));
+  EXPECT_THAT(table.line(2), Eq("three"));
+}
+
+TEST(LineTable, MapsEmptyFile)
+{
+  auto table = LineTable();
+  table.map(tests::writeFile("ci_string_table_empty", ""));
+  EXPECT_THAT(table.size(), Eq(0));
+}
+
+TEST(LineTable, ThrowOnDirectoryPath)
+{
+  auto table = LineTable();
+  EXPECT_ANY_THROW(table.map("."));
+}
+
+TEST(LineTable, CopiesOnlyChangedLines)
+{
+  auto table = LineTable();
+  table.map(tests::writeFile("ci_string_table_cow", "aABCb\nnone\nABC\nx\n"));
+  table.remove(Pattern("ABC"));
+  EXPECT_THAT(table.copied(), Eq(2));
+  EXPECT_THAT(table.line(0), Eq("ab"));
+  EXPECT_THAT(table.line(1), Eq("none"));
+  EXPECT_THAT(table.line(2), Eq(""));
+
+  // copied lines are edited in place afterwards
+  table.remove(Pattern("a"));
+  EXPECT_THAT(table.copied(), Eq(2));
+  EXPECT_THAT(table.line(0), Eq("b"));
+}
+
+TEST(LineTable, SortsAndWritesLikeStrings)
+{
+  auto table = LineTable();
+  auto path = tests::writeFile("ci_string_table_sort", "abd\nABC\n\nabc\nAb");
+  table.map(path);
+  table.sort();
+  {
+    auto out = Writer(path + "_processed");
+    table.write(out);
+  }
+  EXPECT_THAT(tests::readAll(path + "_processed"),
+              Eq("\nAb\nABC\nabc\nabd\n"));
+}
+
+TEST(LineTable, LoadsLinesAcrossArenas)
+{
+  auto content = std::string("short\na line longer than an arena\n\nend");
+  auto path = tests::writeFile("ci_string_table_arena", content);
+  auto table = LineTable();
+  table.load(path, 8);
+  EXPECT_THAT(table.size(), Eq(4));
+  EXPECT_THAT(table.line(0), Eq("short"));
+  EXPECT_THAT(table.line(1), Eq("a line longer than an arena"));
+  EXPECT_THAT(table.line(2), Eq(""));
+  EXPECT_THAT(table.line(3), Eq("end"));
+
+  table.remove(Pattern("line"));
+  EXPECT_THAT(table.copied(), Eq(0));
+  EXPECT_THAT(table.line(1), Eq("a  longer than an arena"));
+}
@@ -0,0 +1,89 @@
+#include <gmock/gmock.h>
+
+#include "../Merge.h"
+#include "../Text.h"
+#include "Files.h"
+
+using ::testing::Eq;
+
+namespace
+{
+std::string sorted(const std::string& name,
+                   const std::string& content,
+                   const std::string& pattern = "")
+{
+  auto path = tests::writeFile(name, content);
+  auto text = Text(path);
+  if (!pattern.empty()) {
+    text.remove(pattern);
+  }
+  text.sort();
+  text.toFile(path);
+  return path;
+}
+}
+
+TEST(Merge, GivesSortOfConcatenation)
+{
+  auto all = std::string();
+  auto inputs = std::vector<std::string>();
+  auto removedInputs = std::vector<std::string>();
+  // 0 to 5 inputs, also some that aren't a power of two and an empty one
+  for (size_t count = 0; count <= 5; ++count) {
+    auto content = count == 2 ? "" : tests::sample(100 + count * 37);
+    content += count % 2 ? "b\nB\n" : "B\nb\n";
+    inputs.push_back(
+      sorted("ci_string_merge_in" + std::to_string(count), content));
+    removedInputs.push_back(sorted(
+      "ci_string_merge_removed" + std::to_string(count), content, "ABC"));
+    all += content;
+
+    auto path = tests::writeFile("ci_string_merge_all", all);
+    auto text = Text(path);
+    text.sort();
+    text.unique();
+    text.toFile();
+    auto uniqueLines = tests::readAll(path + "_processed");
+    auto whole = Text(path);
+    whole.remove("ABC");
+    whole.sort();
+    whole.toFile();
+    auto removed = tests::readAll(path + "_processed");
+
+    auto output = tests::tempPath("ci_string_merge_out");
+    nonstd::mergeSorted(inputs, output, {}, true);
+    EXPECT_THAT(tests::readAll(output), Eq(uniqueLines));
+    nonstd::mergeSorted(removedInputs, output, { "ABC" });
+    EXPECT_THAT(tests::readAll(output), Eq(removed));
+  }
+}
+
+TEST(Merge, RemovesBeforeMerging)
+{
+  // sorted as read but not once 'x' is removed
+  auto path = tests::writeFile("ci_string_merge_removing", "ab\naxa\n");
+  auto output = tests::tempPath("ci_string_merge_out");
+  EXPECT_THROW(nonstd::mergeSorted({ path }, output, { "x" }), const char*);
+
+  auto other = tests::writeFile("ci_string_merge_other", "aa\nac\n");
+  nonstd::mergeSorted({ path, other }, output, { "b" }, true);
+  EXPECT_THAT(tests::readAll(output), Eq("a\naa\nac\naxa\n"));
+}
+
+TEST(Merge, OutputMayBeAnInput)
+{
+  auto path = tests::writeFile("ci_string_merge_self", "a\nc\n");
+  auto other = tests::writeFile("ci_string_merge_other", "b\n");
+  nonstd::mergeSorted({ path, other }, path);
+  EXPECT_THAT(tests::readAll(path), Eq("a\nb\nc\n"));
+  EXPECT_FALSE(tests::hasTemporary(path));
+}
+
+TEST(Merge, ThrowsOnUnsortedInput)
+{
+  auto path = tests::writeFile("ci_string_merge_unsorted", "a\nc\nb\n");
+  auto output = tests::tempPath("ci_string_merge_out");
+  EXPECT_THROW(nonstd::mergeSorted({ path }, output), const char*);
+  EXPECT_THROW(nonstd::mergeSorted({ path + "_missing" }, output),
+               const char*);
+}
@@ -0,0 +1,85 @@
+#include <gmock/gmock.h>
+
+#include <random>
+
+#include "../Newlines.h"
+#include "../Text.h"
+#include "Files.h"
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+
+namespace
+{
+std::vector<std::string> lines(const std::string& data)
+{
+  auto result = std::vector<std::string>();
+  nonstd::forEachLine(data.data(), data.size(), [&](size_t b, size_t e) {
+    result.push_back(data.substr(b, e - b));
+  });
+  return result;
+}
+}
+
+TEST(Newlines, FindsEveryNewlineAtAnyOffset)
+{
+  auto random = std::mt19937(7);
+  auto byte = std::uniform_int_distribution<int>(0, 15);
+  auto data = std::string(1000, '\0');
+  for (auto& c : data) {
+    // '\n' and bytes around it are frequent
+    c = static_cast<char>(byte(random) + 3);
+  }
+  for (size_t offset = 0; offset < 40; ++offset) {
+    auto size = data.size() - offset;
+    auto found = std::vector<uint32_t>(size);
+    found.resize(nonstd::findNewlines(data.data() + offset, size, &found[0]));
+    auto expected = std::vector<uint32_t>();
+    for (size_t i = 0; i < size; ++i) {
+      if (data[offset + i] == '\n') {
+        expected.push_back(i);
+      }
+    }
+    EXPECT_THAT(found, Eq(expected));
+  }
+}
+
+TEST(Newlines, GivesGetlineLines)
+{
+  EXPECT_THAT(lines(""), ElementsAre());
+  EXPECT_THAT(lines("\n"), ElementsAre(""));
+  EXPECT_THAT(lines("a\n\nb"), ElementsAre("a", "", "b"));
+  EXPECT_THAT(lines("a\nb\n"), ElementsAre("a", "b"));
+}
+
+TEST(Newlines, CutsAtLineStarts)
+{
+  auto data = std::string("aaaa\nbb\nc\n\ndddddddd");
+  auto cuts = nonstd::lineAlignedCuts(data.data(), data.size(), 4);
+  ASSERT_THAT(cuts.size(), Eq(5u));
+  EXPECT_THAT(cuts.front(), Eq(0u));
+  EXPECT_THAT(cuts.back(), Eq(data.size()));
+  for (size_t i = 1; i + 1 < cuts.size(); ++i) {
+    EXPECT_TRUE(cuts[i] == data.size() || data[cuts[i] - 1] == '\n');
+    EXPECT_GE(cuts[i], cuts[i - 1]);
+  }
+}
+
+TEST(Newlines, ThreadsLoadSameLines)
+{
+  // above the size a single thread indexes on its own
+  auto path =
+    tests::writeFile("ci_string_newlines_load", tests::sample(300000));
+  for (auto storage : { nonstd::Storage::Strings,
+                        nonstd::Storage::Mapped,
+                        nonstd::Storage::Arena }) {
+    auto load = [&](size_t threads) {
+      auto text = Text(path, storage, threads);
+      text.toFile();
+      return tests::readAll(path + "_processed");
+    };
+    auto expected = load(1);
+    EXPECT_THAT(expected, Eq(tests::readAll(path)));
+    EXPECT_THAT(load(4), Eq(expected));
+  }
+}
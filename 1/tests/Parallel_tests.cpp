@@ -0,0 +1,42 @@
+#include <gmock/gmock.h>
+
+#include <random>
+
+#include "../Parallel.h"
+
+using ::testing::ContainerEq;
+using ::testing::Eq;
+using namespace nonstd;
+
+TEST(ParallelFor, VisitsEveryIndexOnce)
+{
+  for (size_t threads : { 1, 3, 8, 100 }) {
+    auto visits = std::vector<int>(37);
+    parallelFor(visits.size(), threads, [&visits](size_t begin, size_t end) {
+      for (auto i = begin; i < end; ++i) {
+        ++visits[i];
+      }
+    });
+    EXPECT_THAT(visits, ContainerEq(std::vector<int>(37, 1)));
+  }
+}
+
+TEST(ParallelStableSort, GivesSameOrderAsStableSort)
+{
+  auto random = std::mt19937(7);
+  auto key = std::uniform_int_distribution<int>(0, 50);
+  auto values = std::vector<std::pair<int, size_t>>();
+  for (size_t i = 0; i < 20000; ++i) {
+    values.emplace_back(key(random), i);
+  }
+  // only the key is compared, the index shows if equal keys kept their order
+  auto less = [](const std::pair<int, size_t>& a,
+                 const std::pair<int, size_t>& b) { return a.first < b.first; };
+  auto expected = values;
+  std::stable_sort(expected.begin(), expected.end(), less);
+  for (size_t threads : { 2, 3, 5, 8 }) {
+    auto sorted = values;
+    parallelStableSort(sorted, threads, less);
+    EXPECT_THAT(sorted, ContainerEq(expected));
+  }
+}
@@ -0,0 +1,124 @@
+#include <gmock/gmock.h>
+
+#include <random>
+
+#include "../PatternSet.h"
+#include "../Text.h"
+
+using ::testing::Eq;
+using namespace nonstd;
+
+namespace
+{
+nonstd::string removeInSequence(nonstd::string l,
+                                const std::vector<std::string>& patterns)
+{
+  for (const auto& p : patterns) {
+    remove(l, p);
+  }
+  return l;
+}
+
+nonstd::string removeAtOnce(nonstd::string l,
+                            const std::vector<std::string>& patterns)
+{
+  remove(l, PatternSet(patterns));
+  return l;
+}
+}
+
+TEST(PatternSet, FindsLowestIndexOfOccurringPattern)
+{
+  auto set = PatternSet({ "xyz", "bc", "abc" });
+  auto s = std::string("__abc__");
+  EXPECT_THAT(set.firstMatch(s.data(), s.size()), Eq(1));
+  s = "__ab__";
+  EXPECT_THAT(set.firstMatch(s.data(), s.size()), Eq(PatternSet::npos));
+}
+
+TEST(PatternSet, RemovesEveryPattern)
+{
+  auto patterns = std::vector<std::string>{ "secret", "host-1", "ABC" };
+  EXPECT_THAT(removeAtOnce("ABC host-1 has secret key", patterns),
+              Eq("  has  key"));
+}
+
+TEST(PatternSet, IgnoresEmptyPatterns)
+{
+  EXPECT_TRUE(PatternSet({ "", "" }).empty());
+  EXPECT_THAT(removeAtOnce("example", { "", "x" }), Eq("eample"));
+}
+
+TEST(PatternSet, KnowsShortestPattern)
+{
+  auto set = PatternSet({ "abcd", "", "xyz" });
+  EXPECT_THAT(set.shortest(), Eq(3u));
+  EXPECT_THAT(set.size(), Eq(2u));
+  auto s = std::string("xy");
+  EXPECT_THAT(set.firstMatch(s.data(), s.size()), Eq(PatternSet::npos));
+}
+
+TEST(PatternSet, MatchesRemovingInSequence)
+{
+  // removal of one pattern can join the text into another one
+  EXPECT_THAT(removeAtOnce("aXbc", { "X", "abc" }), Eq(""));
+  EXPECT_THAT(removeAtOnce("aXbc", { "abc", "X" }), Eq("abc"));
+  EXPECT_THAT(removeAtOnce("abc", { "bc", "ab" }), Eq("a"));
+  EXPECT_THAT(removeAtOnce("aabb", { "ab", "ab" }), Eq(""));
+  EXPECT_THAT(removeAtOnce("aaab", { "aa", "b", "a" }), Eq(""));
+
+  auto random = std::mt19937(42);
+  auto letter = std::uniform_int_distribution<int>('a', 'c');
+  auto length = std::uniform_int_distribution<int>(1, 4);
+  auto word = [&](size_t n) {
+    auto w = std::string();
+    while (w.size() < n) {
+      w += static_cast<char>(letter(random));
+    }
+    return w;
+  };
+  for (int i = 0; i < 1000; ++i) {
+    auto patterns = std::vector<std::string>();
+    for (int j = 0; j < 4; ++j) {
+      patterns.push_back(word(length(random)));
+    }
+    auto line = nonstd::string(word(40).c_str());
+    EXPECT_THAT(removeAtOnce(line, patterns),
+                Eq(removeInSequence(line, patterns)));
+  }
+}
+
+TEST(PatternSet, IgnoringCaseRemovesEveryVariantInSequence)
+{
+  auto line = std::string("xAbC-abc-ABX-aBx");
+  auto pattern = Pattern("abc", true);
+  line.resize(pattern.removeFrom(&line[0], line.size()));
+  EXPECT_THAT(line, Eq("x--ABX-aBx"));
+
+  auto random = std::mt19937(5);
+  auto letter = std::uniform_int_distribution<int>(0, 5);
+  const char letters[] = { 'a', 'A', 'b', 'B', 'c', '-' };
+  auto length = std::uniform_int_distribution<int>(1, 4);
+  auto word = [&](size_t n) {
+    auto w = std::string();
+    while (w.size() < n) {
+      w += letters[letter(random)];
+    }
+    return w;
+  };
+  for (int i = 0; i < 1000; ++i) {
+    auto patterns = std::vector<std::string>();
+    for (int j = 0; j < 3; ++j) {
+      patterns.push_back(word(length(random)));
+    }
+    auto line = word(40);
+    auto inSequence = line;
+    for (const auto& p : patterns) {
+      auto pattern = Pattern(p, true);
+      inSequence.resize(pattern.removeFrom(&inSequence[0], inSequence.size()));
+    }
+    auto set = PatternSet(patterns, true);
+    line.resize(set.removeFrom(&line[0], line.size()));
+    EXPECT_THAT(line, Eq(inSequence));
+  }
+}
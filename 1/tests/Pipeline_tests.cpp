@@ -0,0 +1,120 @@
+#include <gmock/gmock.h>
+
+#include <fcntl.h>
+#include <thread>
+#include <unistd.h>
+
+#include "../Pipeline.h"
+#include "../Queue.h"
+#include "../Text.h"
+#include "Files.h"
+
+using ::testing::Eq;
+using nonstd::IoBackend;
+
+namespace
+{
+std::vector<IoBackend> backends()
+{
+  auto result = std::vector<IoBackend>{ IoBackend::Threads };
+  if (nonstd::AsyncIo::uringAvailable()) {
+    result.push_back(IoBackend::Uring);
+  }
+  return result;
+}
+
+std::string viaText(const std::string& path)
+{
+  auto text = Text(path);
+  text.remove(std::vector<std::string>{ "ABC", "e1" });
+  text.toFile();
+  return tests::readAll(path + "_processed");
+}
+
+std::string viaPipeline(const std::string& path,
+                        size_t blockSize,
+                        IoBackend backend)
+{
+  auto options = nonstd::PipelineOptions();
+  options.blockSize = blockSize;
+  options.backend = backend;
+  nonstd::filterLines(path,
+                      path + "_filtered",
+                      nonstd::PatternSet({ "ABC", "e1" }),
+                      options);
+  return tests::readAll(path + "_filtered");
+}
+}
+
+TEST(BoundedQueue, PopsInOrderUntilClosed)
+{
+  auto queue = nonstd::BoundedQueue<int>(2);
+  auto producer = std::thread([&queue] {
+    for (int i = 0; i < 100; ++i) {
+      queue.push(i);
+    }
+    queue.close();
+  });
+  auto popped = std::vector<int>();
+  int item;
+  while (queue.pop(item)) {
+    popped.push_back(item);
+  }
+  producer.join();
+  ASSERT_THAT(popped.size(), Eq(100u));
+  EXPECT_THAT(popped.back(), Eq(99));
+}
+
+TEST(AsyncIo, ReadsWhatWasWritten)
+{
+  auto path = tests::tempPath("ci_string_async_io");
+  for (auto backend : backends()) {
+    auto fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+    auto io = nonstd::AsyncIo(backend, 2);
+    io.write(fd, "world", 5, 6, 1);
+    io.write(fd, "hello ", 6, 0, 0);
+    EXPECT_THAT(io.wait().result + io.wait().result, Eq(11));
+    char data[11];
+    io.read(fd, data, sizeof(data), 0, 7);
+    auto done = io.wait();
+    EXPECT_THAT(done.tag, Eq(7u));
+    EXPECT_THAT(std::string(data, done.result), Eq("hello world"));
+    close(fd);
+  }
+}
+
+TEST(Pipeline, FiltersLikeText)
+{
+  auto path = tests::writeFile("ci_string_pipeline", tests::sample(5000));
+  auto expected = viaText(path);
+  for (auto backend : backends()) {
+    for (size_t blockSize : { 1, 7, 4096, 1 << 20 }) {
+      EXPECT_THAT(viaPipeline(path, blockSize, backend), Eq(expected));
+    }
+  }
+}
+
+TEST(Pipeline, HandlesLongLinesAndMissingNewline)
+{
+  auto content = std::string(10000, 'x') + "ABC\n\n\nlast ABC line";
+  auto path = tests::writeFile("ci_string_pipeline_long", content);
+  auto expected = viaText(path);
+  for (auto backend : backends()) {
+    EXPECT_THAT(viaPipeline(path, 64, backend), Eq(expected));
+  }
+}
+
+TEST(Pipeline, CopiesEmptyFile)
+{
+  auto path = tests::writeFile("ci_string_pipeline_empty", "");
+  for (auto backend : backends()) {
+    EXPECT_THAT(viaPipeline(path, 16, backend), Eq(""));
+  }
+}
+
+TEST(Pipeline, ThrowsOnMissingInput)
+{
+  auto to = tests::tempPath("ci_string_pipeline_none");
+  EXPECT_ANY_THROW(nonstd::filterLines("@#&*", to, nonstd::PatternSet({})));
+}
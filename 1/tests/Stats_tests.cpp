@@ -0,0 +1,54 @@
+#include <gmock/gmock.h>
+
+#include "../Text.h"
+#include "Files.h"
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+using ::testing::HasSubstr;
+
+TEST(Stats, MeasuresEveryStageWhenEnabled)
+{
+  auto path = tests::writeFile("ci_string_stats", "ab\nb\nab\n");
+  auto text = Text(path, nonstd::Storage::Mapped);
+  text.remove("a");
+  text.unique();
+  text.sort();
+  text.toFile();
+  EXPECT_THAT(tests::readAll(path + "_processed"), Eq("b\n"));
+
+  const auto& stats = text.stats();
+  if (!nonstd::statsEnabled) {
+    EXPECT_TRUE(stats.stages.empty());
+    EXPECT_THAT(nonstd::toJson(stats), Eq("{\"enabled\":false}"));
+    return;
+  }
+  auto names = std::vector<std::string>();
+  for (const auto& s : stats.stages) {
+    names.push_back(s.name);
+  }
+  EXPECT_THAT(names, ElementsAre("load", "remove", "unique", "sort", "write"));
+  EXPECT_THAT(stats.stages[0].bytesOut, Eq(8u));
+  EXPECT_THAT(stats.stages[1].patternHits, Eq(2u));
+  EXPECT_THAT(stats.stages[1].bytesOut, Eq(6u));
+  EXPECT_THAT(stats.stages[2].linesOut, Eq(1u));
+  EXPECT_GT(stats.peakRssBytes, 0u);
+  EXPECT_THAT(nonstd::toJson(stats), HasSubstr("\"name\":\"remove\""));
+}
+
+TEST(Stats, CountsFusedRemoveAndWrite)
+{
+  auto path = tests::writeFile("ci_string_stats_fused", "ab\nb\n");
+  for (auto storage : { nonstd::Storage::Strings, nonstd::Storage::Mapped }) {
+    auto text = Text(path, storage);
+    text.remove("b");
+    text.toFile();
+    if (nonstd::statsEnabled) {
+      ASSERT_THAT(text.stats().stages.size(), Eq(2u));
+      const auto& fused = text.stats().stages[1];
+      EXPECT_THAT(fused.name, Eq("remove+write"));
+      EXPECT_THAT(fused.patternHits, Eq(2u));
+      EXPECT_THAT(fused.bytesOut, Eq(3u));
+    }
+  }
+}
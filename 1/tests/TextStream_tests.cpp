@@ -0,0 +1,176 @@
+#include <gmock/gmock.h>
+
+#include "../TextStream.h"
+#include "Files.h"
+
+using ::testing::Eq;
+
+namespace
+{
+using tests::readAll;
+
+std::string writeSample(const std::string& name, size_t count)
+{
+  return tests::writeFile(name, tests::sample(count));
+}
+
+std::string viaText(const std::string& path, bool sort, bool unique = false)
+{
+  auto text = Text(path);
+  text.remove("ABC");
+  if (unique) {
+    text.unique();
+  }
+  if (sort) {
+    text.sort();
+  }
+  text.toFile();
+  return readAll(path + "_processed");
+}
+
+std::string viaStream(const std::string& path,
+                      bool sort,
+                      size_t limit,
+                      bool unique = false)
+{
+  auto text = TextStream(path, limit);
+  text.remove("ABC");
+  if (unique) {
+    text.unique();
+  }
+  if (sort) {
+    text.sort();
+  }
+  text.toFile();
+  return readAll(path + "_processed");
+}
+}
+
+TEST(TextStream, ThrowOnInvalidPath)
+{
+  EXPECT_ANY_THROW(TextStream("@#&*"));
+}
+
+TEST(TextStream, ThrowOnDirectoryPath)
+{
+  EXPECT_ANY_THROW(TextStream("."));
+}
+
+TEST(TextStream, RemovesLikeText)
+{
+  auto path = writeSample("ci_string_stream_remove", 1000);
+  auto expected = viaText(path, false);
+  EXPECT_THAT(viaStream(path, false, 256), Eq(expected));
+}
+
+TEST(TextStream, SortsLikeTextWithinMemoryLimit)
+{
+  auto path = writeSample("ci_string_stream_sort", 1000);
+  auto expected = viaText(path, true);
+  EXPECT_THAT(viaStream(path, true, TextStream::defaultMemoryLimit),
+              Eq(expected));
+}
+
+TEST(TextStream, SortsLikeTextWithSpilledRuns)
+{
+  auto path = writeSample("ci_string_stream_spill", 5000);
+  auto expected = viaText(path, true);
+  // small limit produces more runs than one merge pass can take
+  EXPECT_THAT(viaStream(path, true, 512), Eq(expected));
+  EXPECT_FALSE(tests::hasTemporary(path + "_processed"));
+}
+
+TEST(TextStream, UniqueLikeTextWithinMemoryLimit)
+{
+  auto path = writeSample("ci_string_stream_unique", 1000);
+  auto expected = viaText(path, false, true);
+  EXPECT_THAT(viaStream(path, false, TextStream::defaultMemoryLimit, true),
+              Eq(expected));
+}
+
+TEST(TextStream, UniqueLikeTextWithPartitions)
+{
+  auto path = writeSample("ci_string_stream_unique_parts", 5000);
+  auto expected = viaText(path, false, true);
+  EXPECT_THAT(viaStream(path, false, 512, true), Eq(expected));
+  EXPECT_FALSE(tests::hasTemporary(path + "_processed"));
+}
+
+TEST(TextStream, SortedUniqueLikeTextWithSpilledRuns)
+{
+  auto path = writeSample("ci_string_stream_sort_unique", 5000);
+  auto expected = viaText(path, true, true);
+  EXPECT_THAT(viaStream(path, true, 512, true), Eq(expected));
+}
+
+TEST(TextStream, ReplacesOutputOnlyWhenDone)
+{
+  auto path = writeSample("ci_string_stream_in_place", 3000);
+  auto expected = viaText(path, true);
+  // the input is read while the sorted runs spill, then replaced
+  auto text = TextStream(path, 512);
+  text.remove("ABC");
+  text.sort();
+  text.toFile(path);
+  EXPECT_THAT(readAll(path), Eq(expected));
+  EXPECT_FALSE(tests::hasTemporary(path));
+}
+
+TEST(TextStream, KeepsLinesWithNulWhole)
+{
+  using namespace std::string_literals;
+  auto path = tests::writeFile("ci_string_stream_nul",
+                               "b\0x\na\0z\na\0y\na\0y\n"s);
+  // spilled runs and partitions read lines back too
+  for (auto sort : { false, true }) {
+    auto text = TextStream(path, 16);
+    text.unique();
+    if (sort) {
+      text.sort();
+    }
+    text.toFile();
+    EXPECT_THAT(readAll(path + "_processed"),
+                Eq(sort ? "a\0y\na\0z\nb\0x\n"s : "b\0x\na\0z\na\0y\n"s));
+  }
+}
+
+TEST(TextStream, SortFirstLikeText)
+{
+  auto path = writeSample("ci_string_stream_first", 3000);
+  for (auto unique : { false, true }) {
+    for (size_t count : { 0, 1, 10, 5000 }) {
+      auto text = Text(path);
+      text.remove("ABC");
+      if (unique) {
+        text.unique();
+      }
+      text.sortFirst(count);
+      text.toFile();
+      auto expected = readAll(path + "_processed");
+
+      auto stream = TextStream(path, 512);
+      stream.remove("ABC");
+      if (unique) {
+        stream.unique();
+      }
+      stream.sortFirst(count);
+      stream.toFile();
+      EXPECT_THAT(readAll(path + "_processed"), Eq(expected));
+    }
+  }
+}
+
+TEST(TextStream, SortRangeLikeTextWithSpilledRuns)
+{
+  auto path = writeSample("ci_string_stream_range", 3000);
+  auto text = Text(path);
+  text.sortRange("one", "TWO");
+  text.toFile();
+  auto expected = readAll(path + "_processed");
+  EXPECT_FALSE(expected.empty());
+
+  auto stream = TextStream(path, 512);
+  stream.sortRange("one", "TWO");
+  stream.toFile();
+  EXPECT_THAT(readAll(path + "_processed"), Eq(expected));
+}
@@ -1,6 +1,7 @@
 #include <gmock/gmock.h>
 
 #include "../Text.h"
+#include "Files.h"
 
 TEST(Text, ThrowOnInvalidPath)
 {
@@ -11,3 +12,221 @@ TEST(Text, ThrowOnDirectoryPath)
 {
   EXPECT_ANY_THROW(Text("."));
 }
+
+TEST(Text, RemovesPatternSetLikeRemovingOneByOne)
+{
+  auto path = tests::writeFile("ci_string_text_set", tests::sample(500));
+  auto patterns = std::vector<std::string>{ "ABC", "Four", "e1", "zero" };
+  {
+    auto text = Text(path);
+    for (const auto& p : patterns) {
+      text.remove(p);
+    }
+    text.toFile();
+  }
+  auto expected = tests::readAll(path + "_processed");
+  {
+    auto text = Text(path);
+    text.remove(patterns);
+    text.toFile();
+  }
+  EXPECT_THAT(tests::readAll(path + "_processed"), ::testing::Eq(expected));
+}
+
+TEST(Text, TableStoragesGiveSameOutput)
+{
+  auto path = tests::writeFile("ci_string_text_mapped", tests::sample(500));
+  auto process = [&path](nonstd::Storage storage) {
+    auto text = Text(path, storage);
+    text.remove("ABC");
+    text.remove(std::vector<std::string>{ "Four", "e1" });
+    text.sort();
+    text.toFile();
+    return tests::readAll(path + "_processed");
+  };
+  auto expected = process(nonstd::Storage::Strings);
+  EXPECT_THAT(process(nonstd::Storage::Mapped), ::testing::Eq(expected));
+  EXPECT_THAT(process(nonstd::Storage::Arena), ::testing::Eq(expected));
+}
+
+TEST(Text, ThreadsDontChangeOutput)
+{
+  auto path = tests::writeFile("ci_string_text_threads", tests::sample(20000));
+  for (auto storage : { nonstd::Storage::Strings,
+                        nonstd::Storage::Mapped,
+                        nonstd::Storage::Arena }) {
+    auto process = [&path, storage](size_t threads) {
+      auto text = Text(path, storage);
+      text.setThreads(threads);
+      text.setSortAlgorithm(threads == 1 ? nonstd::SortAlgorithm::Comparison
+                                         : nonstd::SortAlgorithm::PrefixKey);
+      text.remove("ABC");
+      text.remove(std::vector<std::string>{ "Four", "e1" });
+      text.sort();
+      text.toFile();
+      return tests::readAll(path + "_processed");
+    };
+    auto expected = process(1);
+    EXPECT_THAT(process(4), ::testing::Eq(expected));
+  }
+}
+
+TEST(Text, WritesToGivenPath)
+{
+  auto path = tests::writeFile("ci_string_text_output", "b\nABCa\n");
+  auto output = tests::tempPath("ci_string_text_output_elsewhere");
+  auto text = Text(path);
+  text.remove("ABC");
+  text.sort();
+  text.toFile(output, 16, true);
+  EXPECT_THAT(tests::readAll(output), ::testing::Eq("a\nb\n"));
+}
+
+TEST(Text, ReplacesOutputAtomically)
+{
+  auto path = tests::writeFile("ci_string_text_atomic", tests::sample(1000));
+  auto output = tests::writeFile("ci_string_text_atomic_out", "old\n");
+  auto expected = tests::sample(1000);
+  for (auto at = expected.find("ABC"); at != std::string::npos;
+       at = expected.find("ABC", at)) {
+    expected.erase(at, 3);
+  }
+  for (size_t threads : { 1, 3 }) {
+    // a reader which opened the old output keeps reading all of it
+    auto reader = std::ifstream(output);
+    auto old = tests::readAll(output);
+    auto text = Text(path);
+    text.setThreads(threads);
+    text.remove("ABC");
+    text.toFile(output);
+    auto kept = std::string(std::istreambuf_iterator<char>(reader),
+                            std::istreambuf_iterator<char>());
+    EXPECT_THAT(kept, ::testing::Eq(old));
+    EXPECT_THAT(tests::readAll(output), ::testing::Eq(expected));
+    EXPECT_FALSE(tests::hasTemporary(output));
+  }
+}
+
+TEST(Text, UniqueGivesSameLinesBeforeAndAfterSort)
+{
+  auto path = tests::writeFile("ci_string_text_unique",
+                               "b\nA\nB\na\nc\nabc\nABC\nA\n");
+  for (auto storage : { nonstd::Storage::Strings,
+                        nonstd::Storage::Mapped,
+                        nonstd::Storage::Arena }) {
+    {
+      auto text = Text(path, storage);
+      text.unique();
+      text.toFile();
+    }
+    EXPECT_THAT(tests::readAll(path + "_processed"),
+                ::testing::Eq("b\nA\nc\nabc\n"));
+    {
+      auto text = Text(path, storage);
+      text.sort();
+      text.unique();
+      text.toFile();
+    }
+    EXPECT_THAT(tests::readAll(path + "_processed"),
+                ::testing::Eq("A\nabc\nb\nc\n"));
+  }
+}
+
+TEST(Text, RecordedOperationsRunInOrder)
+{
+  auto path = tests::writeFile("ci_string_text_pipeline",
+                               "xbAx\nba\nb\nAB\nxxb\n");
+  for (auto storage : { nonstd::Storage::Strings,
+                        nonstd::Storage::Mapped,
+                        nonstd::Storage::Arena }) {
+    for (size_t threads : { 1, 2 }) {
+      auto text = Text(path, storage);
+      text.setThreads(threads);
+      text.remove("x");
+      text.sort();
+      text.sort();
+      text.unique();
+      text.remove("b");
+      text.remove(std::vector<std::string>{ "", "Q" });
+      text.toFile();
+      EXPECT_THAT(tests::readAll(path + "_processed"),
+                  ::testing::Eq("AB\n\nA\n"));
+      // operations run once, writing again gives the same lines
+      text.toFile();
+      EXPECT_THAT(tests::readAll(path + "_processed"),
+                  ::testing::Eq("AB\n\nA\n"));
+    }
+  }
+}
+
+TEST(Text, SortFirstGivesPrefixOfSort)
+{
+  auto path = tests::writeFile("ci_string_text_first",
+                               "b\nB\na\nc\nA\nb\n" + tests::sample(200));
+  auto sorted = [&](nonstd::Storage storage) {
+    auto text = Text(path, storage);
+    text.sort();
+    text.toFile();
+    return tests::readAll(path + "_processed");
+  };
+  for (auto storage : { nonstd::Storage::Strings,
+                        nonstd::Storage::Mapped,
+                        nonstd::Storage::Arena }) {
+    auto all = sorted(storage);
+    for (size_t count : { 0, 1, 3, 50, 1000 }) {
+      auto text = Text(path, storage);
+      text.sortFirst(count);
+      text.toFile();
+      auto expected = all;
+      size_t at = 0;
+      for (size_t i = 0; i < count && at < all.size(); ++i) {
+        at = all.find('\n', at) + 1;
+      }
+      expected.resize(at);
+      EXPECT_THAT(tests::readAll(path + "_processed"), ::testing::Eq(expected));
+    }
+  }
+}
+
+TEST(Text, SortRangeKeepsLinesWithinBounds)
+{
+  auto path =
+    tests::writeFile("ci_string_text_range", "c\nB\na\nbz\nA\nb\nC\n");
+  for (auto storage : { nonstd::Storage::Strings,
+                        nonstd::Storage::Mapped,
+                        nonstd::Storage::Arena }) {
+    auto text = Text(path, storage);
+    text.sortRange("b", "C");
+    text.toFile();
+    EXPECT_THAT(tests::readAll(path + "_processed"),
+                ::testing::Eq("B\nb\nbz\n"));
+
+    auto open = Text(path, storage);
+    open.sortRange("B");
+    open.toFile();
+    EXPECT_THAT(tests::readAll(path + "_processed"),
+                ::testing::Eq("B\nb\nbz\nc\nC\n"));
+  }
+}
+
+TEST(Text, RemovesEveryCaseVariantIgnoringCase)
+{
+  auto path = tests::writeFile("ci_string_text_ignore_case",
+                               "xAbCx\nabc\nABD\naBcABC\n");
+  for (auto storage : { nonstd::Storage::Strings,
+                        nonstd::Storage::Mapped,
+                        nonstd::Storage::Arena }) {
+    auto text = Text(path, storage);
+    text.remove("abc", true);
+    text.remove("D");
+    text.toFile();
+    EXPECT_THAT(tests::readAll(path + "_processed"),
+                ::testing::Eq("xx\n\nAB\n\n"));
+
+    auto several = Text(path, storage);
+    several.remove(std::vector<std::string>{ "abc", "X" }, true);
+    several.toFile();
+    EXPECT_THAT(tests::readAll(path + "_processed"),
+                ::testing::Eq("\n\nABD\n\n"));
+  }
+}
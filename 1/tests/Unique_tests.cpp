@@ -0,0 +1,56 @@
+#include <gmock/gmock.h>
+
+#include "../Unique.h"
+
+using ::testing::ElementsAre;
+using ::testing::Eq;
+
+namespace
+{
+std::vector<std::string> unique(std::vector<std::string> lines)
+{
+  nonstd::uniqueLines(lines, [](const std::string& l) {
+    return std::string_view(l);
+  });
+  return lines;
+}
+}
+
+TEST(Unique, DropsCaseVariantsKeepingFirst)
+{
+  EXPECT_THAT(unique({ "b", "Abc", "B", "aBC", "", "abcd", "", "ABC" }),
+              ElementsAre("b", "Abc", "", "abcd"));
+}
+
+TEST(Unique, FoldedHashIgnoresCaseOnly)
+{
+  auto text = std::string("Some Line With 20+ Characters!");
+  auto lower = std::string("some line with 20+ characters!");
+  EXPECT_THAT(nonstd::foldedHash(text.data(), text.size()),
+              Eq(nonstd::foldedHash(lower.data(), lower.size())));
+  EXPECT_NE(nonstd::foldedHash(text.data(), text.size()),
+            nonstd::foldedHash(text.data(), text.size() - 1));
+}
+
+TEST(Unique, InsertReportsDuplicates)
+{
+  auto lines = std::vector<std::string>{ "one", "two", "ONE", "three" };
+  auto set = nonstd::FingerprintSet();
+  auto view = [&lines](size_t i) { return std::string_view(lines[i]); };
+  EXPECT_TRUE(set.insert(lines[0], 0, view));
+  EXPECT_TRUE(set.insert(lines[1], 1, view));
+  EXPECT_FALSE(set.insert(lines[2], 2, view));
+  EXPECT_TRUE(set.insert(lines[3], 3, view));
+  EXPECT_THAT(set.size(), Eq(3u));
+}
+
+TEST(Unique, ManyLinesGrowTheSet)
+{
+  auto lines = std::vector<std::string>();
+  for (size_t i = 0; i < 10000; ++i) {
+    lines.push_back("line" + std::to_string(i % 1000));
+  }
+  auto result = unique(lines);
+  ASSERT_THAT(result.size(), Eq(1000u));
+  EXPECT_THAT(result[999], Eq("line999"));
+}
@@ -1,7 +1,9 @@
 #include <gmock/gmock.h>
 
+#include <random>
 #include <regex>
 
+#include "../Pattern.h"
 #include "../Text.h"
 
 using ::testing::ContainerEq;
@@ -11,6 +13,19 @@ using ::testing::StartsWith;
 std::string substr = "AbC";
 using namespace nonstd;
 
+namespace
+{
+// nonstd::string equality ignores case, this keeps the exact bytes
+std::vector<std::string> bytes(const Lines& lines)
+{
+  auto result = std::vector<std::string>();
+  for (const auto& l : lines) {
+    result.emplace_back(l.data(), l.size());
+  }
+  return result;
+}
+}
+
 TEST(RemoveReturn, BlankLineIfLineConsistsOfPattern)
 {
   auto l = nonstd::string(substr.c_str());
@@ -108,6 +123,40 @@ TEST(RemoveCanAccept, SpacesAsPattern)
   EXPECT_THAT(l, Eq("example"));
 }
 
+TEST(RemoveReturn, SameResultAsRegexForNonOverlappingMatches)
+{
+  auto l = nonstd::string("aabcbc abcabc");
+  remove(l, std::string("abc"));
+  EXPECT_THAT(l, Eq("abc "));
+}
+
+TEST(RemoveCanAccept, EmptyPattern)
+{
+  auto l = nonstd::string("example");
+  remove(l, std::string());
+  EXPECT_THAT(l, Eq("example"));
+}
+
+TEST(Pattern, FindsFirstOccurrenceFromPosition)
+{
+  auto p = Pattern("needle");
+  auto s = std::string("haystack needle needle");
+  EXPECT_THAT(p.find(s.data(), s.size()), Eq(9));
+  EXPECT_THAT(p.find(s.data(), s.size(), 10), Eq(16));
+  EXPECT_THAT(p.find(s.data(), s.size(), 17), Eq(Pattern::npos));
+  EXPECT_THAT(p.find(s.data(), 3), Eq(Pattern::npos));
+}
+
+TEST(Pattern, CanBeReusedForManyLines)
+{
+  auto p = Pattern(substr);
+  auto lines = Lines{ "AbC", "xAbCy", "none", "AbCAbC" };
+  for (auto& l : lines) {
+    remove(l, p);
+  }
+  EXPECT_THAT(lines, ContainerEq(Lines{ "", "xy", "none", "" }));
+}
+
 TEST(Sort, IsNotCaseSensitive)
 {
   {
@@ -169,3 +218,42 @@ TEST(Sort, CanProcessBlankStrings)
     EXPECT_THAT(lines, ContainerEq(Lines{ "", "", "def" }));
   }
 }
+
+TEST(Sort, GivesSameOrderWithEveryAlgorithm)
+{
+  auto lines = Lines{ "abcdefgh2", "ABCDEFGH1", "abc", "", "ABCDEFGH",
+                      "b",         "abcdefgh1", "A",   "a", "abcdefgh" };
+  auto expected = lines;
+  sort(expected);
+  for (auto algorithm : { SortAlgorithm::Comparison,
+                          SortAlgorithm::PrefixKey,
+                          SortAlgorithm::Radix }) {
+    auto sorted = lines;
+    sort(sorted, 1, algorithm);
+    EXPECT_THAT(bytes(sorted), ContainerEq(bytes(expected)));
+  }
+}
+
+TEST(Sort, GivesSameOrderWithEveryAlgorithmOnSharedPrefixes)
+{
+  auto random = std::mt19937(11);
+  auto letter = std::uniform_int_distribution<int>(0, 5);
+  auto length = std::uniform_int_distribution<int>(0, 12);
+  auto lines = Lines();
+  for (int i = 0; i < 5000; ++i) {
+    auto l = nonstd::string(i % 3 ? "2020-02-24 18:" : "");
+    for (auto n = length(random); n > 0; --n) {
+      l += "aAbB\0c"[letter(random)];
+    }
+    lines.push_back(l);
+  }
+  auto expected = lines;
+  sort(expected);
+  for (size_t threads : { 1, 4 }) {
+    for (auto algorithm : { SortAlgorithm::PrefixKey, SortAlgorithm::Radix }) {
+      auto sorted = lines;
+      sort(sorted, threads, algorithm);
+      EXPECT_THAT(bytes(sorted), ContainerEq(bytes(expected)));
+    }
+  }
+}
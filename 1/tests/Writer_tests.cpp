@@ -0,0 +1,116 @@
+#include <gmock/gmock.h>
+
+#include "../Writer.h"
+#include "Files.h"
+
+#include <atomic>
+#include <sys/stat.h>
+
+using ::testing::Eq;
+using ::testing::Ne;
+using namespace nonstd;
+
+TEST(Writer, ThrowOnInvalidPath)
+{
+  EXPECT_ANY_THROW(Writer("/nonexistent/dir/file"));
+}
+
+TEST(Writer, WritesLinesThroughSmallBuffer)
+{
+  auto path = tests::tempPath("ci_string_writer_small");
+  auto out = Writer(path, 8);
+  out.line("one");
+  out.line("");
+  out.line("seven!");
+  out.line("a line longer than the whole buffer");
+  out.line("end");
+  out.close();
+  EXPECT_THAT(tests::readAll(path),
+              Eq("one\n\nseven!\na line longer than the whole buffer\nend\n"));
+}
+
+TEST(Writer, FlushesOnDestruction)
+{
+  auto path = tests::tempPath("ci_string_writer_destruction");
+  {
+    auto out = Writer(path, 1024, true);
+    out.line("kept");
+  }
+  EXPECT_THAT(tests::readAll(path), Eq("kept\n"));
+}
+
+TEST(Writer, WritesInParallelAsSequentially)
+{
+  auto lines = std::vector<std::string>{
+    "one", "", "seven!", "a line longer than the whole buffer", "end"
+  };
+  auto view = [&lines](size_t i) { return std::string_view(lines[i]); };
+  auto expected = std::string();
+  for (const auto& l : lines) {
+    expected += l + "\n";
+  }
+  auto path = tests::tempPath("ci_string_writer_parallel");
+  for (size_t threads : { 1, 2, 3, 8 }) {
+    writeParallel(path, lines.size(), view, threads, true, 8);
+    EXPECT_THAT(tests::readAll(path), Eq(expected));
+  }
+  writeParallel(path, 0, view, 4);
+  EXPECT_THAT(tests::readAll(path), Eq(""));
+  EXPECT_FALSE(tests::hasTemporary(path));
+}
+
+TEST(Writer, ParallelErrorsReachTheCaller)
+{
+  auto path = tests::writeFile("ci_string_writer_parallel_error", "old\n");
+  auto calls = std::vector<std::atomic<int>>(100);
+  // the second pass, writing, fails on one line
+  auto view = [&calls](size_t i) {
+    if (++calls[i] == 2 && i == 70) {
+      throw "view failed";
+    }
+    return std::string_view("line");
+  };
+  EXPECT_ANY_THROW(writeParallel(path, calls.size(), view, 4));
+  EXPECT_THAT(tests::readAll(path), Eq("old\n"));
+  EXPECT_FALSE(tests::hasTemporary(path));
+}
+
+TEST(Writer, AtomicFileKeepsOldContentUntilCommit)
+{
+  auto path = tests::writeFile("ci_string_writer_atomic", "old\n");
+  {
+    auto file = AtomicFile(path);
+    file.allocate(4);
+    file.write("new\n", 4, 0);
+    EXPECT_THAT(tests::readAll(path), Eq("old\n"));
+  }
+  EXPECT_THAT(tests::readAll(path), Eq("old\n"));
+  EXPECT_FALSE(tests::hasTemporary(path));
+
+  auto file = AtomicFile(path);
+  file.allocate(4);
+  file.write("new\n", 4, 0);
+  file.commit(true);
+  EXPECT_THAT(tests::readAll(path), Eq("new\n"));
+  EXPECT_TRUE(AtomicFile::replaceable(path));
+  EXPECT_TRUE(AtomicFile::replaceable(path + "_missing"));
+  EXPECT_FALSE(AtomicFile::replaceable("/dev/null"));
+}
+
+TEST(Writer, AtomicFileKeepsModeAndTemporariesApart)
+{
+  auto path = tests::writeFile("ci_string_writer_atomic_mode", "old\n");
+  chmod(path.c_str(), 0600);
+  {
+    auto first = AtomicFile(path);
+    auto second = AtomicFile(path);
+    EXPECT_THAT(first.temporary(), Ne(second.temporary()));
+    first.write("new\n", 4, 0);
+    first.commit(false);
+  }
+  struct stat s;
+  ASSERT_THAT(stat(path.c_str(), &s), Eq(0));
+  EXPECT_THAT(s.st_mode & 07777, Eq(0600u));
+  EXPECT_THAT(tests::readAll(path), Eq("new\n"));
+  EXPECT_FALSE(tests::hasTemporary(path));
+}
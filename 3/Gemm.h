@@ -0,0 +1,203 @@
+#ifndef GEMM_H
+#define GEMM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace linal
+{
+namespace detail
+{
+// N * M * P up to which gemm() multiplies without packing
+constexpr size_t smallProduct = 16 * 16 * 16;
+
+constexpr size_t roundUp(size_t value, size_t step)
+{
+  return (value + step - 1) / step * step;
+}
+
+/**
+ * @brief Tile sizes of an N x M by M x P product with element type W
+ *
+ * @details
+ * A micro tile of mr x nr elements of the result stays in registers while a
+ * kc long panel of both operands streams through it. An mc x kc block of the
+ * lhs is sized for L2 and a kc x nc panel of the rhs for L3. Tiles never
+ * exceed the rounded up matrix dimensions, so small products pack little.
+ */
+template<typename W, size_t N, size_t M, size_t P>
+struct GemmTiles
+{
+  static constexpr size_t mr = std::min<size_t>(4, N);
+  static constexpr size_t nr =
+    std::min<size_t>(std::max<size_t>(4, 32 / sizeof(W)), P);
+  static constexpr size_t kc = std::min<size_t>(256, M);
+  static constexpr size_t mc = std::min(roundUp(N, mr), roundUp(96, mr));
+  static constexpr size_t nc = std::min(roundUp(P, nr), roundUp(2048, nr));
+};
+
+/**
+ * @brief Copy rows [row, row + rows) x columns [k, k + depth) of the lhs
+ *
+ * @details
+ * Every mr rows become one panel laid out column after column, missing rows
+ * of the last one are zero.
+ */
+template<typename W, size_t mr, typename Row>
+void packLhs(Row lhs, size_t row, size_t rows, size_t k, size_t depth, W* to)
+{
+  for (size_t i = 0; i < rows; i += mr) {
+    for (size_t ii = 0; ii < mr; ++ii) {
+      if (i + ii < rows) {
+        const auto* from = lhs(row + i + ii) + k;
+        for (size_t p = 0; p < depth; ++p) {
+          to[p * mr + ii] = static_cast<W>(from[p]);
+        }
+      } else {
+        for (size_t p = 0; p < depth; ++p) {
+          to[p * mr + ii] = W(0);
+        }
+      }
+    }
+    to += mr * depth;
+  }
+}
+
+/**
+ * @brief Copy rows [k, k + depth) x columns [column, column + columns) of the
+ * rhs
+ *
+ * @details
+ * Every nr columns become one panel laid out row after row, missing columns
+ * of the last one are zero.
+ */
+template<typename W, size_t nr, typename Row>
+void packRhs(Row rhs,
+             size_t k,
+             size_t depth,
+             size_t column,
+             size_t columns,
+             W* to)
+{
+  for (size_t j = 0; j < columns; j += nr) {
+    auto width = std::min(nr, columns - j);
+    for (size_t p = 0; p < depth; ++p) {
+      const auto* from = rhs(k + p) + column + j;
+      for (size_t jj = 0; jj < width; ++jj) {
+        to[p * nr + jj] = static_cast<W>(from[jj]);
+      }
+      for (size_t jj = width; jj < nr; ++jj) {
+        to[p * nr + jj] = W(0);
+      }
+    }
+    to += nr * depth;
+  }
+}
+
+/**
+ * @brief Add the product of an mr wide lhs panel and an nr wide rhs panel to
+ * a rows x columns corner of the result
+ */
+template<typename W, size_t mr, size_t nr, typename Row>
+void microKernel(size_t depth,
+                 const W* a,
+                 const W* b,
+                 Row result,
+                 size_t row,
+                 size_t column,
+                 size_t rows,
+                 size_t columns)
+{
+  W acc[mr][nr] = {};
+  for (size_t p = 0; p < depth; ++p) {
+    for (size_t i = 0; i < mr; ++i) {
+      for (size_t j = 0; j < nr; ++j) {
+        acc[i][j] += a[i] * b[j];
+      }
+    }
+    a += mr;
+    b += nr;
+  }
+  for (size_t i = 0; i < rows; ++i) {
+    auto* to = result(row + i) + column;
+    for (size_t j = 0; j < columns; ++j) {
+      to[j] += acc[i][j];
+    }
+  }
+}
+
+/**
+ * @brief Row by row product for matrices too small to pay for packing
+ */
+template<typename W, size_t N, size_t M, size_t P, typename L, typename R,
+         typename C>
+void gemmSmall(L lhs, R rhs, C result)
+{
+  for (size_t i = 0; i < N; ++i) {
+    const auto* a = lhs(i);
+    W row[P] = {};
+    for (size_t k = 0; k < M; ++k) {
+      auto aik = static_cast<W>(a[k]);
+      const auto* b = rhs(k);
+      for (size_t j = 0; j < P; ++j) {
+        row[j] += aik * static_cast<W>(b[j]);
+      }
+    }
+    std::copy(row, row + P, result(i));
+  }
+}
+
+/**
+ * @brief Set the result to the N x M lhs times the M x P rhs
+ *
+ * @details
+ * lhs(i), rhs(i) and result(i) give a pointer to the first element of row i,
+ * rows needn't be adjacent. Operands are converted to W while packed, so the
+ * micro kernel multiplies and sums in W only. Small products skip packing,
+ * it would cost more than the multiplication.
+ */
+template<typename W, size_t N, size_t M, size_t P, typename L, typename R,
+         typename C>
+void gemm(L lhs, R rhs, C result)
+{
+  if constexpr (N * M * P <= smallProduct) {
+    gemmSmall<W, N, M, P>(lhs, rhs, result);
+    return;
+  }
+  for (size_t i = 0; i < N; ++i) {
+    std::fill(result(i), result(i) + P, W(0));
+  }
+  using Tiles = GemmTiles<W, N, M, P>;
+  constexpr auto mr = Tiles::mr;
+  constexpr auto nr = Tiles::nr;
+  auto a = std::vector<W>(Tiles::mc * Tiles::kc);
+  auto b = std::vector<W>(Tiles::kc * Tiles::nc);
+  for (size_t jc = 0; jc < P; jc += Tiles::nc) {
+    auto nc = std::min(Tiles::nc, P - jc);
+    for (size_t pc = 0; pc < M; pc += Tiles::kc) {
+      auto kc = std::min(Tiles::kc, M - pc);
+      packRhs<W, nr>(rhs, pc, kc, jc, nc, b.data());
+      for (size_t ic = 0; ic < N; ic += Tiles::mc) {
+        auto mc = std::min(Tiles::mc, N - ic);
+        packLhs<W, mr>(lhs, ic, mc, pc, kc, a.data());
+        for (size_t jr = 0; jr < nc; jr += nr) {
+          for (size_t ir = 0; ir < mc; ir += mr) {
+            microKernel<W, mr, nr>(kc,
+                                   a.data() + ir * kc,
+                                   b.data() + jr * kc,
+                                   result,
+                                   ic + ir,
+                                   jc + jr,
+                                   std::min(mr, mc - ir),
+                                   std::min(nr, nc - jr));
+          }
+        }
+      }
+    }
+  }
+}
+}
+}
+
+#endif
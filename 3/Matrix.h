@@ -1,3 +1,4 @@
+#include "Gemm.h"
 #include "Vector.h"
 #include "traits.h"
 #include <array>
@@ -143,27 +144,61 @@ private:
   std::array<Vector<T, columns_count>, rows_count> _rows;
 };
 
-template<typename Q, typename L, size_t N, size_t M, size_t P>
-auto operator*(const Matrix<Q, N, M>& lhs, const Matrix<L, M, P>& rhs)
-  -> Matrix<typename is_safe_arithmetic_conversion<Q, L>::wider_type, N, P>
+/**
+ * @brief Multiply 'lhs' by 'rhs' into 'res', tiled for registers and caches
+ *
+ * @details
+ * Lets big matrices live on the heap, operator*() returns its result by
+ * value. 'res' is overwritten.
+ */
+template<typename Q, typename L, typename W, size_t N, size_t M, size_t P>
+void multiply(const Matrix<Q, N, M>& lhs,
+              const Matrix<L, M, P>& rhs,
+              Matrix<W, N, P>& res)
+{
+  static_assert(
+    std::is_same<W,
+                 typename is_safe_arithmetic_conversion<Q, L>::wider_type>::
+      value,
+    "result type must be the wider one");
+  detail::gemm<W, N, M, P>(
+    [&lhs](size_t i) {
+      return (lhs.cbegin() + i)->data();
+    },
+    [&rhs](size_t i) {
+      return (rhs.cbegin() + i)->data();
+    },
+    [&res](size_t i) {
+      return (res.begin() + i)->mutableData();
+    });
+}
+
+/**
+ * @brief Multiply 'lhs' by 'rhs' into 'res' one inner product at a time
+ *
+ * @details
+ * Reference for multiply(), walks the rhs column by column.
+ */
+template<typename Q, typename L, typename W, size_t N, size_t M, size_t P>
+void multiplyNaive(const Matrix<Q, N, M>& lhs,
+                   const Matrix<L, M, P>& rhs,
+                   Matrix<W, N, P>& res)
 {
-  auto res =
-    Matrix<typename is_safe_arithmetic_conversion<Q, L>::wider_type, N, P>();
   auto column = std::array<const L*, M>();
   size_t k = 0;
-  for (auto& row : rhs._rows) {
-    column.at(k++) = &row.at(0);
+  for (auto row = rhs.cbegin(); row != rhs.cend(); ++row) {
+    column.at(k++) = &row->at(0);
   }
 
+  auto lhsRow = lhs.cbegin();
   for (size_t i = 0; i < P; ++i) {
     for (size_t j = 0; j < N; ++j) {
       auto val = std::inner_product(
-        lhs._rows.at(j).cbegin(),
-        lhs._rows.at(j).cend(),
+        (lhsRow + j)->cbegin(),
+        (lhsRow + j)->cend(),
         column.cbegin(),
-        static_cast<typename is_safe_arithmetic_conversion<Q, L>::wider_type>(
-          0),
-        std::plus<typename is_safe_arithmetic_conversion<Q, L>::wider_type>(),
+        static_cast<W>(0),
+        std::plus<W>(),
         [](const Q& lhs, const L* rhs) {
           return lhs * (*rhs);
         });
@@ -174,7 +209,15 @@ auto operator*(const Matrix<Q, N, M>& lhs, const Matrix<L, M, P>& rhs)
         return ++p;
       });
   }
+}
 
+template<typename Q, typename L, size_t N, size_t M, size_t P>
+auto operator*(const Matrix<Q, N, M>& lhs, const Matrix<L, M, P>& rhs)
+  -> Matrix<typename is_safe_arithmetic_conversion<Q, L>::wider_type, N, P>
+{
+  auto res =
+    Matrix<typename is_safe_arithmetic_conversion<Q, L>::wider_type, N, P>();
+  multiply(lhs, rhs, res);
   return res;
 }
 
@@ -0,0 +1,782 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__SSE2__)
+#define LINAL_SIMD_X86 1
+#include <immintrin.h>
+#define LINAL_AVX2 __attribute__((target("avx2,fma")))
+#define LINAL_AVX512 __attribute__((target("avx512f")))
+#else
+#define LINAL_SIMD_X86 0
+#endif
+
+namespace linal
+{
+namespace simd
+{
+/**
+ * @brief Instruction sets the kernels are written for, ordered by width
+ */
+enum class Isa { Scalar, Sse2, Avx2, Avx512 };
+
+/**
+ * @brief Alignment in bytes of data the kernels take, also the widest vector
+ */
+constexpr size_t alignment = 64;
+
+/**
+ * @brief 'n' elements of T rounded up to whole alignment blocks
+ */
+template<typename T>
+constexpr size_t paddedSize(size_t n)
+{
+  constexpr auto step = alignment / sizeof(T);
+  return (n + step - 1) / step * step;
+}
+
+/**
+ * @brief Element types with kernels
+ */
+template<typename T>
+struct is_simd_type
+  : std::integral_constant<bool,
+                           std::is_same<T, float>::value ||
+                             std::is_same<T, double>::value ||
+                             std::is_same<T, int32_t>::value>
+{
+};
+
+/**
+ * @brief Widest instruction set the running CPU supports
+ */
+inline Isa supportedIsa()
+{
+#if LINAL_SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return Isa::Avx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return Isa::Avx2;
+  }
+  return Isa::Sse2;
+#else
+  return Isa::Scalar;
+#endif
+}
+
+/**
+ * @brief Instruction set the kernels dispatch to, detected once
+ */
+inline Isa& activeIsa()
+{
+  static auto isa = supportedIsa();
+  return isa;
+}
+
+namespace scalar
+{
+template<typename T>
+void add(T* y, const T* x, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) {
+    y[i] += x[i];
+  }
+}
+
+template<typename T>
+void scale(T* y, T a, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) {
+    y[i] *= a;
+  }
+}
+
+template<typename T>
+void axpy(T a, const T* x, T* y, size_t n)
+{
+  for (size_t i = 0; i < n; ++i) {
+    y[i] += a * x[i];
+  }
+}
+
+template<typename T>
+T dot(const T* x, const T* y, size_t n)
+{
+  auto sum = T(0);
+  for (size_t i = 0; i < n; ++i) {
+    sum += x[i] * y[i];
+  }
+  return sum;
+}
+}
+
+#if LINAL_SIMD_X86
+namespace sse2
+{
+template<typename T>
+struct Ops;
+
+template<>
+struct Ops<float>
+{
+  using V = __m128;
+  static constexpr size_t width = 4;
+
+  static V load(const float* p)
+  {
+    return _mm_load_ps(p);
+  }
+
+  static void store(float* p, V v)
+  {
+    _mm_store_ps(p, v);
+  }
+
+  static V set(float a)
+  {
+    return _mm_set1_ps(a);
+  }
+
+  static V add(V a, V b)
+  {
+    return _mm_add_ps(a, b);
+  }
+
+  static V mul(V a, V b)
+  {
+    return _mm_mul_ps(a, b);
+  }
+
+  // a * x + y
+  static V fma(V a, V x, V y)
+  {
+    return _mm_add_ps(_mm_mul_ps(a, x), y);
+  }
+
+  static float sum(V v)
+  {
+    v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    v = _mm_add_ss(v, _mm_shuffle_ps(v, v, 1));
+    return _mm_cvtss_f32(v);
+  }
+};
+
+template<>
+struct Ops<double>
+{
+  using V = __m128d;
+  static constexpr size_t width = 2;
+
+  static V load(const double* p)
+  {
+    return _mm_load_pd(p);
+  }
+
+  static void store(double* p, V v)
+  {
+    _mm_store_pd(p, v);
+  }
+
+  static V set(double a)
+  {
+    return _mm_set1_pd(a);
+  }
+
+  static V add(V a, V b)
+  {
+    return _mm_add_pd(a, b);
+  }
+
+  static V mul(V a, V b)
+  {
+    return _mm_mul_pd(a, b);
+  }
+
+  static V fma(V a, V x, V y)
+  {
+    return _mm_add_pd(_mm_mul_pd(a, x), y);
+  }
+
+  static double sum(V v)
+  {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+  }
+};
+
+template<>
+struct Ops<int32_t>
+{
+  using V = __m128i;
+  static constexpr size_t width = 4;
+
+  static V load(const int32_t* p)
+  {
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(p));
+  }
+
+  static void store(int32_t* p, V v)
+  {
+    _mm_store_si128(reinterpret_cast<__m128i*>(p), v);
+  }
+
+  static V set(int32_t a)
+  {
+    return _mm_set1_epi32(a);
+  }
+
+  static V add(V a, V b)
+  {
+    return _mm_add_epi32(a, b);
+  }
+
+  // SSE2 has no 32 bit mullo, low halves of 64 bit products are the same
+  static V mul(V a, V b)
+  {
+    auto even = _mm_mul_epu32(a, b);
+    auto odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    const int low = _MM_SHUFFLE(0, 0, 2, 0);
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, low),
+                              _mm_shuffle_epi32(odd, low));
+  }
+
+  static V fma(V a, V x, V y)
+  {
+    return _mm_add_epi32(mul(a, x), y);
+  }
+
+  static int32_t sum(V v)
+  {
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+  }
+};
+
+template<typename T>
+void add(T* y, const T* x, size_t n)
+{
+  using O = Ops<T>;
+  for (size_t i = 0; i < n; i += O::width) {
+    O::store(y + i, O::add(O::load(y + i), O::load(x + i)));
+  }
+}
+
+template<typename T>
+void scale(T* y, T a, size_t n)
+{
+  using O = Ops<T>;
+  auto va = O::set(a);
+  for (size_t i = 0; i < n; i += O::width) {
+    O::store(y + i, O::mul(O::load(y + i), va));
+  }
+}
+
+template<typename T>
+void axpy(T a, const T* x, T* y, size_t n)
+{
+  using O = Ops<T>;
+  auto va = O::set(a);
+  for (size_t i = 0; i < n; i += O::width) {
+    O::store(y + i, O::fma(va, O::load(x + i), O::load(y + i)));
+  }
+}
+
+template<typename T>
+T dot(const T* x, const T* y, size_t n)
+{
+  using O = Ops<T>;
+  // independent sums hide the latency of adds
+  auto s0 = O::set(0);
+  auto s1 = O::set(0);
+  size_t i = 0;
+  for (; i + 2 * O::width <= n; i += 2 * O::width) {
+    s0 = O::fma(O::load(x + i), O::load(y + i), s0);
+    s1 = O::fma(O::load(x + i + O::width), O::load(y + i + O::width), s1);
+  }
+  if (i < n) {
+    s0 = O::fma(O::load(x + i), O::load(y + i), s0);
+  }
+  return O::sum(O::add(s0, s1));
+}
+}
+
+namespace avx2
+{
+template<typename T>
+struct Ops;
+
+template<>
+struct Ops<float>
+{
+  using V = __m256;
+  static constexpr size_t width = 8;
+
+  LINAL_AVX2 static V load(const float* p)
+  {
+    return _mm256_load_ps(p);
+  }
+
+  LINAL_AVX2 static void store(float* p, V v)
+  {
+    _mm256_store_ps(p, v);
+  }
+
+  LINAL_AVX2 static V set(float a)
+  {
+    return _mm256_set1_ps(a);
+  }
+
+  LINAL_AVX2 static V add(V a, V b)
+  {
+    return _mm256_add_ps(a, b);
+  }
+
+  LINAL_AVX2 static V mul(V a, V b)
+  {
+    return _mm256_mul_ps(a, b);
+  }
+
+  LINAL_AVX2 static V fma(V a, V x, V y)
+  {
+    return _mm256_fmadd_ps(a, x, y);
+  }
+
+  LINAL_AVX2 static float sum(V v)
+  {
+    return sse2::Ops<float>::sum(
+      _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+  }
+};
+
+template<>
+struct Ops<double>
+{
+  using V = __m256d;
+  static constexpr size_t width = 4;
+
+  LINAL_AVX2 static V load(const double* p)
+  {
+    return _mm256_load_pd(p);
+  }
+
+  LINAL_AVX2 static void store(double* p, V v)
+  {
+    _mm256_store_pd(p, v);
+  }
+
+  LINAL_AVX2 static V set(double a)
+  {
+    return _mm256_set1_pd(a);
+  }
+
+  LINAL_AVX2 static V add(V a, V b)
+  {
+    return _mm256_add_pd(a, b);
+  }
+
+  LINAL_AVX2 static V mul(V a, V b)
+  {
+    return _mm256_mul_pd(a, b);
+  }
+
+  LINAL_AVX2 static V fma(V a, V x, V y)
+  {
+    return _mm256_fmadd_pd(a, x, y);
+  }
+
+  LINAL_AVX2 static double sum(V v)
+  {
+    return sse2::Ops<double>::sum(
+      _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1)));
+  }
+};
+
+template<>
+struct Ops<int32_t>
+{
+  using V = __m256i;
+  static constexpr size_t width = 8;
+
+  LINAL_AVX2 static V load(const int32_t* p)
+  {
+    return _mm256_load_si256(reinterpret_cast<const __m256i*>(p));
+  }
+
+  LINAL_AVX2 static void store(int32_t* p, V v)
+  {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(p), v);
+  }
+
+  LINAL_AVX2 static V set(int32_t a)
+  {
+    return _mm256_set1_epi32(a);
+  }
+
+  LINAL_AVX2 static V add(V a, V b)
+  {
+    return _mm256_add_epi32(a, b);
+  }
+
+  LINAL_AVX2 static V mul(V a, V b)
+  {
+    return _mm256_mullo_epi32(a, b);
+  }
+
+  LINAL_AVX2 static V fma(V a, V x, V y)
+  {
+    return _mm256_add_epi32(_mm256_mullo_epi32(a, x), y);
+  }
+
+  LINAL_AVX2 static int32_t sum(V v)
+  {
+    return sse2::Ops<int32_t>::sum(_mm_add_epi32(
+      _mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+  }
+};
+
+template<typename T>
+LINAL_AVX2 void add(T* y, const T* x, size_t n)
+{
+  using O = Ops<T>;
+  for (size_t i = 0; i < n; i += O::width) {
+    O::store(y + i, O::add(O::load(y + i), O::load(x + i)));
+  }
+}
+
+template<typename T>
+LINAL_AVX2 void scale(T* y, T a, size_t n)
+{
+  using O = Ops<T>;
+  auto va = O::set(a);
+  for (size_t i = 0; i < n; i += O::width) {
+    O::store(y + i, O::mul(O::load(y + i), va));
+  }
+}
+
+template<typename T>
+LINAL_AVX2 void axpy(T a, const T* x, T* y, size_t n)
+{
+  using O = Ops<T>;
+  auto va = O::set(a);
+  for (size_t i = 0; i < n; i += O::width) {
+    O::store(y + i, O::fma(va, O::load(x + i), O::load(y + i)));
+  }
+}
+
+template<typename T>
+LINAL_AVX2 T dot(const T* x, const T* y, size_t n)
+{
+  using O = Ops<T>;
+  auto s0 = O::set(0);
+  auto s1 = O::set(0);
+  size_t i = 0;
+  for (; i + 2 * O::width <= n; i += 2 * O::width) {
+    s0 = O::fma(O::load(x + i), O::load(y + i), s0);
+    s1 = O::fma(O::load(x + i + O::width), O::load(y + i + O::width), s1);
+  }
+  if (i < n) {
+    s0 = O::fma(O::load(x + i), O::load(y + i), s0);
+  }
+  return O::sum(O::add(s0, s1));
+}
+}
+
+namespace avx512
+{
+template<typename T>
+struct Ops;
+
+template<>
+struct Ops<float>
+{
+  using V = __m512;
+  static constexpr size_t width = 16;
+
+  LINAL_AVX512 static V load(const float* p)
+  {
+    return _mm512_load_ps(p);
+  }
+
+  LINAL_AVX512 static void store(float* p, V v)
+  {
+    _mm512_store_ps(p, v);
+  }
+
+  LINAL_AVX512 static V set(float a)
+  {
+    return _mm512_set1_ps(a);
+  }
+
+  LINAL_AVX512 static V add(V a, V b)
+  {
+    return _mm512_add_ps(a, b);
+  }
+
+  LINAL_AVX512 static V mul(V a, V b)
+  {
+    return _mm512_mul_ps(a, b);
+  }
+
+  LINAL_AVX512 static V fma(V a, V x, V y)
+  {
+    return _mm512_fmadd_ps(a, x, y);
+  }
+
+  LINAL_AVX512 static float sum(V v)
+  {
+    // through memory, GCC 12 warns on intrinsics splitting 512 bit vectors
+    alignas(alignment) float lanes[width];
+    store(lanes, v);
+    using H = avx2::Ops<float>;
+    return H::sum(H::add(H::load(lanes), H::load(lanes + H::width)));
+  }
+};
+
+template<>
+struct Ops<double>
+{
+  using V = __m512d;
+  static constexpr size_t width = 8;
+
+  LINAL_AVX512 static V load(const double* p)
+  {
+    return _mm512_load_pd(p);
+  }
+
+  LINAL_AVX512 static void store(double* p, V v)
+  {
+    _mm512_store_pd(p, v);
+  }
+
+  LINAL_AVX512 static V set(double a)
+  {
+    return _mm512_set1_pd(a);
+  }
+
+  LINAL_AVX512 static V add(V a, V b)
+  {
+    return _mm512_add_pd(a, b);
+  }
+
+  LINAL_AVX512 static V mul(V a, V b)
+  {
+    return _mm512_mul_pd(a, b);
+  }
+
+  LINAL_AVX512 static V fma(V a, V x, V y)
+  {
+    return _mm512_fmadd_pd(a, x, y);
+  }
+
+  LINAL_AVX512 static double sum(V v)
+  {
+    // through memory, GCC 12 warns on intrinsics splitting 512 bit vectors
+    alignas(alignment) double lanes[width];
+    store(lanes, v);
+    using H = avx2::Ops<double>;
+    return H::sum(H::add(H::load(lanes), H::load(lanes + H::width)));
+  }
+};
+
+template<>
+struct Ops<int32_t>
+{
+  using V = __m512i;
+  static constexpr size_t width = 16;
+
+  LINAL_AVX512 static V load(const int32_t* p)
+  {
+    return _mm512_load_si512(p);
+  }
+
+  LINAL_AVX512 static void store(int32_t* p, V v)
+  {
+    _mm512_store_si512(p, v);
+  }
+
+  LINAL_AVX512 static V set(int32_t a)
+  {
+    return _mm512_set1_epi32(a);
+  }
+
+  LINAL_AVX512 static V add(V a, V b)
+  {
+    return _mm512_add_epi32(a, b);
+  }
+
+  LINAL_AVX512 static V mul(V a, V b)
+  {
+    return _mm512_mullo_epi32(a, b);
+  }
+
+  LINAL_AVX512 static V fma(V a, V x, V y)
+  {
+    return _mm512_add_epi32(_mm512_mullo_epi32(a, x), y);
+  }
+
+  LINAL_AVX512 static int32_t sum(V v)
+  {
+    // through memory, GCC 12 warns on intrinsics splitting 512 bit vectors
+    alignas(alignment) int32_t lanes[width];
+    store(lanes, v);
+    using H = avx2::Ops<int32_t>;
+    return H::sum(H::add(H::load(lanes), H::load(lanes + H::width)));
+  }
+};
+
+template<typename T>
+LINAL_AVX512 void add(T* y, const T* x, size_t n)
+{
+  using O = Ops<T>;
+  for (size_t i = 0; i < n; i += O::width) {
+    O::store(y + i, O::add(O::load(y + i), O::load(x + i)));
+  }
+}
+
+template<typename T>
+LINAL_AVX512 void scale(T* y, T a, size_t n)
+{
+  using O = Ops<T>;
+  auto va = O::set(a);
+  for (size_t i = 0; i < n; i += O::width) {
+    O::store(y + i, O::mul(O::load(y + i), va));
+  }
+}
+
+template<typename T>
+LINAL_AVX512 void axpy(T a, const T* x, T* y, size_t n)
+{
+  using O = Ops<T>;
+  auto va = O::set(a);
+  for (size_t i = 0; i < n; i += O::width) {
+    O::store(y + i, O::fma(va, O::load(x + i), O::load(y + i)));
+  }
+}
+
+template<typename T>
+LINAL_AVX512 T dot(const T* x, const T* y, size_t n)
+{
+  using O = Ops<T>;
+  auto s0 = O::set(0);
+  auto s1 = O::set(0);
+  size_t i = 0;
+  for (; i + 2 * O::width <= n; i += 2 * O::width) {
+    s0 = O::fma(O::load(x + i), O::load(y + i), s0);
+    s1 = O::fma(O::load(x + i + O::width), O::load(y + i + O::width), s1);
+  }
+  if (i < n) {
+    s0 = O::fma(O::load(x + i), O::load(y + i), s0);
+  }
+  return O::sum(O::add(s0, s1));
+}
+}
+#endif
+
+/**
+ * @brief Kernels for T on one instruction set
+ */
+template<typename T>
+struct Kernels
+{
+  void (*add)(T*, const T*, size_t);
+  void (*scale)(T*, T, size_t);
+  void (*axpy)(T, const T*, T*, size_t);
+  T (*dot)(const T*, const T*, size_t);
+};
+
+template<typename T>
+Kernels<T> kernelsFor(Isa isa)
+{
+  static_assert(is_simd_type<T>::value, "no kernel for element type");
+#if LINAL_SIMD_X86
+  switch (isa) {
+    case Isa::Avx512:
+      return { avx512::add<T>, avx512::scale<T>, avx512::axpy<T>,
+               avx512::dot<T> };
+    case Isa::Avx2:
+      return { avx2::add<T>, avx2::scale<T>, avx2::axpy<T>, avx2::dot<T> };
+    case Isa::Sse2:
+      return { sse2::add<T>, sse2::scale<T>, sse2::axpy<T>, sse2::dot<T> };
+    case Isa::Scalar:
+      break;
+  }
+#endif
+  return { scalar::add<T>, scalar::scale<T>, scalar::axpy<T>, scalar::dot<T> };
+}
+
+/**
+ * @brief Kernels for activeIsa(), resolved on first use
+ */
+template<typename T>
+Kernels<T>& kernels()
+{
+  static auto k = kernelsFor<T>(activeIsa());
+  return k;
+}
+
+/**
+ * @brief Dispatch to 'isa' or the widest supported one below it
+ *
+ * @details
+ * Meant for tests and benchmarks, not synchronized with running kernels.
+ */
+inline void useIsa(Isa isa)
+{
+  activeIsa() = std::min(isa, supportedIsa());
+  kernels<float>() = kernelsFor<float>(activeIsa());
+  kernels<double>() = kernelsFor<double>(activeIsa());
+  kernels<int32_t>() = kernelsFor<int32_t>(activeIsa());
+}
+
+// pointers below are aligned to 'alignment' and 'n' elements fill whole
+// alignment blocks, every load and store is an aligned full vector
+
+/**
+ * @brief y[i] += x[i] for i in [0, n)
+ */
+template<typename T>
+void add(T* y, const T* x, size_t n)
+{
+  kernels<T>().add(y, x, n);
+}
+
+/**
+ * @brief y[i] *= a for i in [0, n)
+ */
+template<typename T>
+void scale(T* y, T a, size_t n)
+{
+  kernels<T>().scale(y, a, n);
+}
+
+/**
+ * @brief y[i] += a * x[i] for i in [0, n), fused where the CPU has FMA
+ */
+template<typename T>
+void axpy(T a, const T* x, T* y, size_t n)
+{
+  kernels<T>().axpy(a, x, y, n);
+}
+
+/**
+ * @brief Sum of x[i] * y[i] for i in [0, n)
+ *
+ * @details
+ * Vector lanes sum separately, so floating point results may differ from a
+ * sequential sum in the last bits.
+ */
+template<typename T>
+T dot(const T* x, const T* y, size_t n)
+{
+  return kernels<T>().dot(x, y, n);
+}
+}
+}
+
+#endif
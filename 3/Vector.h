@@ -6,11 +6,15 @@
 #include <functional>
 #include <iostream>
 #include <numeric>
+#include <stdexcept>
 
+#include "Simd.h"
 #include "traits.h"
 
 namespace linal
 {
+template<typename T, size_t rows_count, size_t columns_count>
+class Matrix;
 
 /**
  * @brief Vector abstraction
@@ -25,15 +29,28 @@ namespace linal
  * auto v = Vector<int, 3>(1, 2, 3);
  * v += Vector<int, 1>(); // error
  * @endcode
+ *
+ * Vectors of float, double or int32_t filling at least a cache line are cache
+ * line aligned and zero padded to whole cache lines, arithmetic on them runs
+ * SIMD kernels picked once for the running CPU over the padded length.
+ * Smaller ones, like 3D vectors, keep inline loops the compiler unrolls.
  */
 template<typename T, size_t size>
 class Vector
 {
 public:
+  static constexpr size_t vectorizedBytes = simd::alignment;
+  static constexpr bool vectorized =
+    simd::is_simd_type<T>::value && size * sizeof(T) >= vectorizedBytes;
+  // elements stored, the ones past size are zero
+  static constexpr size_t padded =
+    vectorized ? simd::paddedSize<T>(size) : size;
+
   typedef T type;
-  typedef typename std::array<T, size> inner_type;
+  typedef typename std::array<T, padded> inner_type;
   typedef typename inner_type::iterator iterator;
   typedef typename inner_type::const_iterator const_iterator;
+
   inline iterator begin() noexcept
   {
     return _arr.begin();
@@ -46,12 +63,12 @@ public:
 
   inline iterator end() noexcept
   {
-    return _arr.end();
+    return _arr.begin() + size;
   }
 
   inline const_iterator cend() const noexcept
   {
-    return _arr.cend();
+    return _arr.cbegin() + size;
   }
 
   template<typename... Args>
@@ -82,7 +99,10 @@ public:
    */
   const T& at(size_t index) const
   {
-    return _arr.at(index);
+    if (index >= size) {
+      throw std::out_of_range("Vector::at");
+    }
+    return _arr[index];
   }
 
   /**
@@ -93,7 +113,18 @@ public:
    */
   void set(size_t index, T value)
   {
-    _arr.at(index) = value;
+    if (index >= size) {
+      throw std::out_of_range("Vector::set");
+    }
+    _arr[index] = value;
+  }
+
+  /**
+   * @brief Pointer to the first element, the others and the padding follow it
+   */
+  const T* data() const noexcept
+  {
+    return _arr.data();
   }
 
   /**
@@ -121,7 +152,11 @@ public:
     if (!is_safe_arithmetic_conversion<T, U>::value) {
       throw "vectors cannot be added: narrowing of type!";
     }
-    std::transform(begin(), end(), rhs.cbegin(), begin(), std::plus<T>());
+    if constexpr (std::is_same<T, U>::value && S == size && vectorized) {
+      simd::add(mutableData(), rhs.data(), padded);
+    } else {
+      std::transform(begin(), end(), rhs.cbegin(), begin(), std::plus<T>());
+    }
     return *this;
   }
 
@@ -139,11 +174,15 @@ public:
     if (!is_safe_arithmetic_conversion<T, U>::value) {
       throw "vectors cannot be added: narrowing of type!";
     }
-    std::transform(
-      begin(),
-      end(),
-      begin(),
-      std::bind(std::multiplies<T>(), std::placeholders::_1, value));
+    auto scalar = static_cast<T>(value);
+    if constexpr (vectorized) {
+      simd::scale(mutableData(), scalar, padded);
+      clearPadding();
+    } else {
+      std::transform(begin(), end(), begin(), [scalar](const T& x) {
+        return x * scalar;
+      });
+    }
     return *this;
   }
 
@@ -161,7 +200,28 @@ public:
   friend std::ostream& operator<<(std::ostream& os, const Vector<U, S>& v);
 
 private:
-  std::array<T, size> _arr;
+  // kernels rely on zero padding, only these write past the elements
+  template<typename A, typename U, typename Q, size_t S>
+  friend Vector<A, S>& axpy(const U& a, const Vector<Q, S>& x, Vector<A, S>& y);
+  template<typename Q, typename L, typename W, size_t N, size_t M, size_t P>
+  friend void multiply(const Matrix<Q, N, M>& lhs,
+                       const Matrix<L, M, P>& rhs,
+                       Matrix<W, N, P>& res);
+
+  T* mutableData() noexcept
+  {
+    return _arr.data();
+  }
+
+  /**
+   * @brief Zero the padding again, 0 times inf or NaN isn't zero
+   */
+  void clearPadding() noexcept
+  {
+    std::fill(_arr.begin() + size, _arr.end(), T(0));
+  }
+
+  alignas(vectorized ? simd::alignment : alignof(inner_type)) inner_type _arr{};
 };
 
 template<typename U, typename Q, size_t S>
@@ -226,8 +286,8 @@ template<typename T, size_t size>
 std::ostream& operator<<(std::ostream& os, const Vector<T, size>& v)
 {
   os << "{ ";
-  for (const auto& i : v._arr) {
-    os << i << " ";
+  for (size_t i = 0; i < size; ++i) {
+    os << v._arr[i] << " ";
   }
   os << "}" << std::endl;
   return os;
@@ -246,11 +306,52 @@ std::ostream& operator<<(std::ostream& os, const Vector<T, size>& v)
 template<typename U, typename Q, size_t S>
 auto dot(const Vector<U, S>& a, const Vector<Q, S>& b)
 {
-  return std::inner_product(
-    a.cbegin(),
-    a.cend(),
-    b.cbegin(),
-    static_cast<typename is_safe_arithmetic_conversion<U, Q>::wider_type>(0));
+  if constexpr (std::is_same<U, Q>::value && Vector<U, S>::vectorized) {
+    return simd::dot(a.data(), b.data(), Vector<U, S>::padded);
+  } else {
+    return std::inner_product(
+      a.cbegin(),
+      a.cend(),
+      b.cbegin(),
+      static_cast<typename is_safe_arithmetic_conversion<U, Q>::wider_type>(
+        0));
+  }
+}
+
+/**
+ * @brief Add 'a' times 'x' to 'y' in one pass
+ *
+ * @tparam T Vector type of y
+ * @tparam U Scalar type
+ * @tparam Q Vector type of x
+ * @tparam S Vector dimension
+ * @param a Scalar value
+ * @param x
+ * @param y
+ *
+ * @return ref to y
+ */
+template<typename T, typename U, typename Q, size_t S>
+Vector<T, S>& axpy(const U& a, const Vector<Q, S>& x, Vector<T, S>& y)
+{
+  if (!is_safe_arithmetic_conversion<T, U>::value ||
+      !is_safe_arithmetic_conversion<T, Q>::value) {
+    throw "vectors cannot be added: narrowing of type!";
+  }
+  auto scalar = static_cast<T>(a);
+  if constexpr (std::is_same<T, Q>::value && Vector<T, S>::vectorized) {
+    simd::axpy(scalar, x.data(), y.mutableData(), Vector<T, S>::padded);
+    y.clearPadding();
+  } else {
+    std::transform(y.begin(),
+                   y.end(),
+                   x.cbegin(),
+                   y.begin(),
+                   [scalar](const T& y, const Q& x) {
+                     return y + scalar * x;
+                   });
+  }
+  return y;
 }
 
 /**
@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include "../Matrix.h"
+
+namespace
+{
+// big matrices don't fit on the stack
+template<typename T, size_t N>
+std::unique_ptr<linal::Matrix<T, N, N>> makeMatrix(size_t seed)
+{
+  auto m = std::make_unique<linal::Matrix<T, N, N>>();
+  for (size_t i = 0; i < N; ++i) {
+    for (size_t j = 0; j < N; ++j) {
+      m->set(i, j, T((i * 7 + j * 3 + seed) % 17) / T(4));
+    }
+  }
+  return m;
+}
+
+template<typename T, size_t N, typename F>
+void run(benchmark::State& state, F multiply)
+{
+  auto a = makeMatrix<T, N>(1);
+  auto b = makeMatrix<T, N>(2);
+  auto c = makeMatrix<T, N>(0);
+  for (auto _ : state) {
+    multiply(*a, *b, *c);
+    benchmark::DoNotOptimize(c->at(N - 1, N - 1));
+    benchmark::ClobberMemory();
+  }
+  state.counters["flops"] = benchmark::Counter(
+    2.0 * N * N * N, benchmark::Counter::kIsIterationInvariantRate);
+}
+}
+
+template<typename T, size_t N>
+static void BM_MultiplyNaive(benchmark::State& state)
+{
+  run<T, N>(state, [](const auto& a, const auto& b, auto& c) {
+    linal::multiplyNaive(a, b, c);
+  });
+}
+
+template<typename T, size_t N>
+static void BM_MultiplyTiled(benchmark::State& state)
+{
+  run<T, N>(state, [](const auto& a, const auto& b, auto& c) {
+    linal::multiply(a, b, c);
+  });
+}
+
+#define MATRIX_BENCHMARKS(T)                                                   \
+  BENCHMARK_TEMPLATE(BM_MultiplyNaive, T, 3);                                  \
+  BENCHMARK_TEMPLATE(BM_MultiplyTiled, T, 3);                                  \
+  BENCHMARK_TEMPLATE(BM_MultiplyNaive, T, 4);                                  \
+  BENCHMARK_TEMPLATE(BM_MultiplyTiled, T, 4);                                  \
+  BENCHMARK_TEMPLATE(BM_MultiplyNaive, T, 64)->Unit(benchmark::kMillisecond);  \
+  BENCHMARK_TEMPLATE(BM_MultiplyTiled, T, 64)->Unit(benchmark::kMillisecond);  \
+  BENCHMARK_TEMPLATE(BM_MultiplyNaive, T, 128)->Unit(benchmark::kMillisecond); \
+  BENCHMARK_TEMPLATE(BM_MultiplyTiled, T, 128)->Unit(benchmark::kMillisecond); \
+  BENCHMARK_TEMPLATE(BM_MultiplyNaive, T, 256)->Unit(benchmark::kMillisecond); \
+  BENCHMARK_TEMPLATE(BM_MultiplyTiled, T, 256)->Unit(benchmark::kMillisecond); \
+  BENCHMARK_TEMPLATE(BM_MultiplyNaive, T, 512)->Unit(benchmark::kMillisecond); \
+  BENCHMARK_TEMPLATE(BM_MultiplyTiled, T, 512)->Unit(benchmark::kMillisecond); \
+  BENCHMARK_TEMPLATE(BM_MultiplyNaive, T, 1024)                                \
+    ->Unit(benchmark::kMillisecond);                                           \
+  BENCHMARK_TEMPLATE(BM_MultiplyTiled, T, 1024)->Unit(benchmark::kMillisecond)
+
+MATRIX_BENCHMARKS(float);
+MATRIX_BENCHMARKS(double);
+MATRIX_BENCHMARKS(int);
@@ -0,0 +1,110 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include "../Vector.h"
+
+namespace
+{
+template<typename T, size_t S>
+std::unique_ptr<linal::Vector<T, S>> makeVector(size_t seed)
+{
+  auto v = std::make_unique<linal::Vector<T, S>>();
+  for (size_t i = 0; i < S; ++i) {
+    v->set(i, T((i * 7 + seed) % 17));
+  }
+  return v;
+}
+
+// instruction set in range(0), see linal::simd::Isa
+bool useIsa(benchmark::State& state)
+{
+  auto isa = static_cast<linal::simd::Isa>(state.range(0));
+  linal::simd::useIsa(isa);
+  if (linal::simd::activeIsa() != isa) {
+    state.SkipWithError("instruction set not supported");
+    return false;
+  }
+  return true;
+}
+
+template<size_t S>
+void report(benchmark::State& state)
+{
+  state.SetItemsProcessed(state.iterations() * S);
+  linal::simd::useIsa(linal::simd::supportedIsa());
+}
+}
+
+template<typename T, size_t S>
+static void BM_Add(benchmark::State& state)
+{
+  auto x = makeVector<T, S>(1);
+  auto y = makeVector<T, S>(2);
+  if (!useIsa(state)) {
+    return;
+  }
+  for (auto _ : state) {
+    *y += *x;
+    benchmark::ClobberMemory();
+  }
+  report<S>(state);
+}
+
+template<typename T, size_t S>
+static void BM_Scale(benchmark::State& state)
+{
+  auto y = makeVector<T, S>(2);
+  auto a = T(1);
+  // keeps the factor unknown to the compiler
+  benchmark::DoNotOptimize(a);
+  if (!useIsa(state)) {
+    return;
+  }
+  for (auto _ : state) {
+    *y *= a;
+    benchmark::ClobberMemory();
+  }
+  report<S>(state);
+}
+
+template<typename T, size_t S>
+static void BM_Axpy(benchmark::State& state)
+{
+  auto x = makeVector<T, S>(1);
+  auto y = makeVector<T, S>(2);
+  if (!useIsa(state)) {
+    return;
+  }
+  for (auto _ : state) {
+    linal::axpy(T(1), *x, *y);
+    benchmark::ClobberMemory();
+  }
+  report<S>(state);
+}
+
+template<typename T, size_t S>
+static void BM_Dot(benchmark::State& state)
+{
+  auto x = makeVector<T, S>(1);
+  auto y = makeVector<T, S>(2);
+  if (!useIsa(state)) {
+    return;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(linal::dot(*x, *y));
+  }
+  report<S>(state);
+}
+
+#define VECTOR_BENCHMARKS(T, S)                                                \
+  BENCHMARK_TEMPLATE(BM_Add, T, S)->DenseRange(0, 3);                          \
+  BENCHMARK_TEMPLATE(BM_Scale, T, S)->DenseRange(0, 3);                        \
+  BENCHMARK_TEMPLATE(BM_Axpy, T, S)->DenseRange(0, 3);                         \
+  BENCHMARK_TEMPLATE(BM_Dot, T, S)->DenseRange(0, 3)
+
+// one cache line, the smallest size the kernels take
+VECTOR_BENCHMARKS(float, 16);
+VECTOR_BENCHMARKS(float, 4096);
+VECTOR_BENCHMARKS(double, 4096);
+VECTOR_BENCHMARKS(int32_t, 4096);
@@ -246,3 +246,31 @@ TEST(MatrixAddition, worksForMatricesOfSameDimensions)
     EXPECT_THAT(m.at(1, 1), FloatEq(8 + 4.4));
   }
 }
+
+TEST(MatrixMultiplication, tiledEqualsNaiveAcrossTileEdges)
+{
+  auto lhs = Matrix<int, 37, 300>();
+  auto rhs = Matrix<float, 300, 45>();
+  for (size_t i = 0; i < 37; ++i) {
+    for (size_t j = 0; j < 300; ++j) {
+      lhs.set(i, j, int((i * 7 + j * 3) % 11) - 5);
+    }
+  }
+  for (size_t i = 0; i < 300; ++i) {
+    for (size_t j = 0; j < 45; ++j) {
+      rhs.set(i, j, float((i * 5 + j) % 13) * 0.25f);
+    }
+  }
+  auto tiled = Matrix<float, 37, 45>();
+  auto naive = Matrix<float, 37, 45>();
+  multiply(lhs, rhs, tiled);
+  multiplyNaive(lhs, rhs, naive);
+  for (size_t i = 0; i < 37; ++i) {
+    for (size_t j = 0; j < 45; ++j) {
+      // quarters of small integers, so sums are exact in any order
+      EXPECT_THAT(tiled.at(i, j), Eq(naive.at(i, j)));
+    }
+  }
+  Matrix<float, 37, 45> product = lhs * rhs;
+  EXPECT_THAT(product.at(36, 44), Eq(naive.at(36, 44)));
+}
@@ -1,5 +1,7 @@
 #include <gmock/gmock.h>
 
+#include <limits>
+
 #include "../Vector.h"
 
 using namespace linal;
@@ -128,3 +130,88 @@ TEST(Vector, returnScalarMultiplication)
     EXPECT_THAT(v.at(2), Eq(303.3f));
   }
 }
+
+namespace
+{
+template<typename T, size_t S>
+linal::Vector<T, S> sequence(int step)
+{
+  auto v = linal::Vector<T, S>();
+  for (size_t i = 0; i < S; ++i) {
+    v.set(i, T(int(i * step % 23) - 11) / T(4));
+  }
+  return v;
+}
+
+// quarters of small integers keep every result exact in any summation order
+template<typename T>
+void expectKernelsLikeScalar()
+{
+  const size_t S = 37;
+  auto x = sequence<T, S>(5);
+  auto y = sequence<T, S>(7);
+  EXPECT_TRUE((linal::Vector<T, S>::vectorized));
+  EXPECT_THAT(reinterpret_cast<uintptr_t>(x.data()) % 64, Eq(0u));
+
+  auto expected = T(0);
+  for (size_t i = 0; i < S; ++i) {
+    expected += x.at(i) * y.at(i);
+  }
+  EXPECT_THAT(linal::dot(x, y), Eq(expected));
+
+  auto sum = y;
+  sum += x;
+  auto scaled = y;
+  scaled *= T(3);
+  auto fused = y;
+  linal::axpy(T(2), x, fused);
+  for (size_t i = 0; i < S; ++i) {
+    EXPECT_THAT(sum.at(i), Eq(y.at(i) + x.at(i)));
+    EXPECT_THAT(scaled.at(i), Eq(y.at(i) * T(3)));
+    EXPECT_THAT(fused.at(i), Eq(y.at(i) + T(2) * x.at(i)));
+  }
+}
+}
+
+TEST(SimdKernels, giveScalarResultsOnEveryInstructionSet)
+{
+  using linal::simd::Isa;
+  for (auto isa : { Isa::Scalar, Isa::Sse2, Isa::Avx2, Isa::Avx512 }) {
+    linal::simd::useIsa(isa);
+    expectKernelsLikeScalar<float>();
+    expectKernelsLikeScalar<double>();
+    expectKernelsLikeScalar<int32_t>();
+  }
+  linal::simd::useIsa(linal::simd::supportedIsa());
+}
+
+TEST(SimdKernels, keepPaddingZero)
+{
+  using V = linal::Vector<float, 17>;
+  EXPECT_THAT(V::padded, Eq(32u));
+  auto x = V();
+  x.set(0, 1.0f);
+  auto y = V();
+  y.set(0, 2.0f);
+  auto inf = std::numeric_limits<float>::infinity();
+  auto scaled = x;
+  scaled *= inf;
+  auto fused = y;
+  linal::axpy(inf, x, fused);
+  for (size_t i = 17; i < V::padded; ++i) {
+    EXPECT_THAT(scaled.data()[i], Eq(0.0f));
+    EXPECT_THAT(fused.data()[i], Eq(0.0f));
+  }
+  EXPECT_THAT(linal::dot(x, y), Eq(2.0f));
+  EXPECT_THAT(std::distance(x.begin(), x.end()), Eq(17));
+  EXPECT_ANY_THROW(x.at(17));
+}
+
+TEST(SimdKernels, keepNarrowingChecks)
+{
+  auto v = linal::Vector<int, 32>();
+  EXPECT_ANY_THROW(v *= 1.5f);
+  EXPECT_ANY_THROW(linal::axpy(1.5f, linal::Vector<int, 32>(), v));
+  EXPECT_ANY_THROW(linal::axpy(2, linal::Vector<float, 32>(), v));
+  EXPECT_FALSE((linal::Vector<int, 3>::vectorized));
+}